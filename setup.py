@@ -0,0 +1,24 @@
+"""
+Build script for the optional native extensions
+
+Usage:
+    python setup.py build_ext --inplace
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+from setuptools import setup, Extension
+
+setup(
+    name="rigol_gui_native",
+    package_dir={"": "src"},
+    py_modules=[],
+    ext_modules=[
+        Extension(
+            "_rasterizer",
+            sources=["src/native/rasterizer.cpp"],
+            language="c++",
+            extra_compile_args=["-O3", "-std=c++17"],
+        ),
+    ],
+)
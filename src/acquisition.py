@@ -0,0 +1,445 @@
+"""
+Waveform frame acquisition for the RIGOL DHO954
+A frame is one read of every enabled analog and digital channel
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import re
+import time
+import queue
+import logging
+import threading
+from collections.abc import MutableMapping
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterable, Iterator, List, Optional, Tuple
+
+import numpy as np
+
+from edge_index import EdgeIndex
+
+logger = logging.getLogger(__name__)
+
+
+@dataclass
+class RawChannel:
+    """
+    ADC codes of an analog channel with the :WAV:PRE? scale factors
+
+    Times and volts are computed on request, for the whole record or only
+    for a range of samples, so frames hold 1-2 bytes per sample.
+    """
+    codes: np.ndarray  # uint8 (BYTE) or uint16 (WORD)
+    x_origin: float
+    x_increment: float
+    y_increment: float
+    y_origin: float
+    y_reference: float
+
+    @classmethod
+    def from_preamble(cls, preamble: Dict[str, float], codes: np.ndarray) -> 'RawChannel':
+        """Wrap codes read with RigolDHO954.get_waveform_raw"""
+        return cls(codes, preamble['x_origin'], preamble['x_increment'], preamble['y_increment'],
+                   preamble['y_origin'], preamble['y_reference'])
+
+    def __len__(self) -> int:
+        return len(self.codes)
+
+    @property
+    def zero_code(self) -> float:
+        """Code of 0 V"""
+        return self.y_reference + self.y_origin
+
+    def to_codes(self, volts: float) -> float:
+        """Voltage as a (fractional) code, for comparing against codes directly"""
+        return volts / self.y_increment + self.zero_code
+
+    def times(self, start: int = 0, stop: Optional[int] = None) -> np.ndarray:
+        """Times in seconds of samples start..stop-1"""
+        stop = len(self.codes) if stop is None else min(stop, len(self.codes))
+        return self.x_origin + np.arange(start, max(stop, start)) * self.x_increment
+
+    def voltages(self, start: int = 0, stop: Optional[int] = None, dtype=np.float64) -> np.ndarray:
+        """
+        Samples start..stop-1 scaled to volts
+
+        Args:
+            start: First sample index
+            stop: Sample index after the last one (default: end of record)
+            dtype: np.float64, or np.float32 for display paths (exact for
+                8/12/16-bit codes up to the final scaling)
+        """
+        codes = self.codes[start:stop]
+        scalar = np.dtype(dtype).type
+        if scalar is np.float64:
+            return (codes - self.zero_code) * self.y_increment
+        return (codes.astype(scalar) - scalar(self.zero_code)) * scalar(self.y_increment)
+
+    def time_range(self) -> Tuple[float, float]:
+        """Times of the first and the last sample"""
+        return self.x_origin, self.x_origin + max(len(self.codes) - 1, 0) * self.x_increment
+
+    def index_range(self, time_range: Tuple[float, float]) -> Tuple[int, int]:
+        """Sample slice covering a time range, with samples outside it on both sides"""
+        n = len(self.codes)
+        first = int(np.floor((time_range[0] - self.x_origin) / self.x_increment)) - 1
+        last = int(np.ceil((time_range[1] - self.x_origin) / self.x_increment)) + 1
+        return int(np.clip(first, 0, n)), int(np.clip(last + 1, 0, n))
+
+
+class AnalogChannels(MutableMapping):
+    """
+    The (time, voltage) arrays of a frame's analog channels keyed by channel
+
+    Channels held as raw codes are converted when they are looked up and the
+    result is not kept, so a frame stays at the size of its codes; callers
+    that only need part of a record use WaveformFrame.analog_window.
+    Assigning arrays to a channel replaces its raw codes.
+    """
+
+    def __init__(self, raw: Dict[int, RawChannel], arrays: Optional[Dict] = None):
+        """
+        Args:
+            raw: The frame's raw code channels (shared, not copied)
+            arrays: Channels given as (time, voltage) arrays
+        """
+        self.raw = raw
+        self.arrays: Dict[int, Tuple[np.ndarray, np.ndarray]] = dict(arrays or {})
+
+    def __getitem__(self, ch: int) -> Tuple[np.ndarray, np.ndarray]:
+        if ch in self.arrays:
+            return self.arrays[ch]
+        raw = self.raw[ch]
+        return raw.times(), raw.voltages()
+
+    def __setitem__(self, ch: int, value: Tuple[np.ndarray, np.ndarray]) -> None:
+        self.raw.pop(ch, None)
+        self.arrays[ch] = value
+
+    def __delitem__(self, ch: int) -> None:
+        if ch not in self:
+            raise KeyError(ch)
+        self.raw.pop(ch, None)
+        self.arrays.pop(ch, None)
+
+    def __contains__(self, ch) -> bool:
+        return ch in self.arrays or ch in self.raw
+
+    def __iter__(self) -> Iterator[int]:
+        return iter(dict.fromkeys(list(self.arrays) + list(self.raw)))
+
+    def __len__(self) -> int:
+        return len(set(self.arrays) | set(self.raw))
+
+    def __repr__(self) -> str:
+        return f"AnalogChannels({sorted(self)})"
+
+    def time_range(self, ch: int) -> Tuple[float, float]:
+        """Times of the first and the last sample of a channel, without converting it"""
+        if ch in self.arrays:
+            time_data = self.arrays[ch][0]
+            return (float(time_data[0]), float(time_data[-1])) if len(time_data) else (0.0, 0.0)
+        return self.raw[ch].time_range()
+
+    def length(self, ch: int) -> int:
+        """Number of samples of a channel"""
+        return len(self.arrays[ch][0]) if ch in self.arrays else len(self.raw[ch])
+
+
+@dataclass
+class WaveformFrame:
+    """
+    One acquisition of all enabled channels (digital channels as edge indices)
+
+    Analog channels read as binary codes are kept as codes in raw, so they can
+    be stored without loss; analog presents them in volts on demand.
+    """
+    timestamp: float
+    analog: Dict[int, Tuple[np.ndarray, np.ndarray]] = field(default_factory=dict)
+    digital: Dict[int, EdgeIndex] = field(default_factory=dict)
+    sequence: int = 0
+    raw: Dict[int, RawChannel] = field(default_factory=dict)
+
+    def __post_init__(self):
+        if not isinstance(self.analog, AnalogChannels):
+            self.analog = AnalogChannels(self.raw, self.analog)
+
+    def raw_channel(self, ch: int) -> Optional[RawChannel]:
+        """Raw codes of an analog channel, or None if it is held as arrays"""
+        return None if ch in self.analog.arrays else self.raw.get(ch)
+
+    def analog_samples(self, ch: int, dtype=np.float64) -> Tuple[np.ndarray, float]:
+        """
+        Voltages of a whole channel and its sample interval, without a time array
+
+        Args:
+            ch: Analog channel number
+            dtype: Voltage dtype (np.float32 halves the conversion traffic)
+
+        Returns:
+            Tuple of (voltages, sample interval in seconds)
+        """
+        raw = self.raw_channel(ch)
+        if raw is not None:
+            return raw.voltages(dtype=dtype), raw.x_increment
+        time_data, voltage_data = self.analog[ch]
+        dt = float(time_data[1] - time_data[0]) if len(time_data) > 1 else 1.0
+        return np.asarray(voltage_data, dtype=dtype), dt
+
+    def analog_window(self, ch: int, time_range: Optional[Tuple[float, float]] = None,
+                      dtype=np.float64) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        (time, voltage) of the samples of a channel inside a time range
+
+        Only those samples of raw code channels are converted; array channels
+        are sliced without copying (unless dtype differs).
+
+        Args:
+            ch: Analog channel number
+            time_range: (start, end) in seconds; defaults to the whole record
+            dtype: Voltage dtype
+        """
+        raw = self.raw_channel(ch)
+        if raw is not None:
+            start, stop = (0, len(raw)) if time_range is None else raw.index_range(time_range)
+            return raw.times(start, stop), raw.voltages(start, stop, dtype)
+        time_data, voltage_data = self.analog[ch]
+        if time_range is not None:
+            first, last = np.searchsorted(time_data, time_range)
+            window = slice(max(first - 1, 0), last + 1)
+            time_data, voltage_data = time_data[window], voltage_data[window]
+        return time_data, np.asarray(voltage_data, dtype=dtype)
+
+    @property
+    def nbytes(self) -> int:
+        """Memory held by the channel data (shared arrays counted once)"""
+        arrays = {id(a): a.nbytes for pair in self.analog.arrays.values() for a in pair}
+        arrays.update((id(r.codes), r.codes.nbytes) for r in self.raw.values())
+        return sum(arrays.values()) + sum(trace.nbytes for trace in self.digital.values())
+
+
+class AcquisitionPipeline:
+    """
+    Hands every acquired frame to the analysis stages and keeps the newest
+    one for the display
+
+    Stages run synchronously on the acquiring thread, so they see every frame
+    at the full acquisition rate. The display polls take_latest() at its own
+    cadence and only ever renders the most recent frame.
+    """
+
+    def __init__(self):
+        """Initialize an empty pipeline"""
+        self._stages: List[Callable[[WaveformFrame], None]] = []
+        self._lock = threading.Lock()
+        self._latest: Optional[WaveformFrame] = None
+        self._latest_taken = True
+        self._last_submit: Optional[float] = None
+        self.frames_acquired = 0
+        self.acquisition_rate = 0.0
+
+    def add_stage(self, stage: Callable[[WaveformFrame], None]) -> None:
+        """
+        Register an analysis stage
+
+        Args:
+            stage: Callable invoked with every acquired frame
+        """
+        with self._lock:
+            self._stages = self._stages + [stage]
+
+    def remove_stage(self, stage: Callable[[WaveformFrame], None]) -> None:
+        """Unregister an analysis stage"""
+        with self._lock:
+            self._stages = [s for s in self._stages if s != stage]
+
+    def submit(self, frame: WaveformFrame) -> None:
+        """
+        Publish an acquired frame
+
+        Args:
+            frame: Newly acquired frame
+        """
+        for stage in self._stages:
+            try:
+                stage(frame)
+            except Exception as e:
+                logger.error(f"Analysis stage {getattr(stage, '__name__', stage)} error: {e}")
+
+        now = time.monotonic()
+        with self._lock:
+            self._latest = frame
+            self._latest_taken = False
+            self.frames_acquired += 1
+            if self._last_submit is not None and now > self._last_submit:
+                # Smoothed frames per second
+                rate = 1.0 / (now - self._last_submit)
+                self.acquisition_rate = rate if self.acquisition_rate == 0 else 0.8 * self.acquisition_rate + 0.2 * rate
+            self._last_submit = now
+
+    def take_latest(self) -> Optional[WaveformFrame]:
+        """
+        Get the newest frame if it has not been taken yet
+
+        Returns:
+            Newest unseen frame, or None if nothing new was acquired since the last call
+        """
+        with self._lock:
+            if self._latest_taken:
+                return None
+            self._latest_taken = True
+            return self._latest
+
+    @property
+    def latest(self) -> Optional[WaveformFrame]:
+        """Newest acquired frame, whether or not it has been displayed"""
+        with self._lock:
+            return self._latest
+
+    def reset_rate(self) -> None:
+        """Restart acquisition rate measurement (e.g. when acquisition is paused)"""
+        with self._lock:
+            self._last_submit = None
+            self.acquisition_rate = 0.0
+
+
+def acquire_frame(scope, analog_channels: Iterable[int], digital_channels: Iterable[int],
+                  points: int, sequence: int = 0) -> WaveformFrame:
+    """
+    Read one frame from the oscilloscope
+
+    Channels that fail to read are logged and left out of the frame.
+
+    Args:
+        scope: Connected RigolDHO954 instance
+        analog_channels: Analog channel numbers (1-4) to read
+        digital_channels: Digital channel numbers (0-15) to read
+        points: Number of data points per channel
+        sequence: Frame sequence number
+
+    Returns:
+        Acquired WaveformFrame
+    """
+    frame = WaveformFrame(timestamp=time.time(), sequence=sequence)
+
+    for ch in analog_channels:
+        try:
+            frame.raw[ch] = RawChannel.from_preamble(*scope.get_waveform_raw(ch, points))
+        except Exception as e:
+            logger.error(f"Error reading channel {ch}: {e}")
+
+    for d in digital_channels:
+        try:
+            frame.digital[d] = EdgeIndex.from_samples(*scope.get_digital_data(d, points))
+        except Exception as e:
+            logger.error(f"Error reading digital channel {d}: {e}")
+
+    return frame
+
+
+def live_frames(scope, analog_channels: Iterable[int], digital_channels: Iterable[int],
+                points: int, count: Optional[int] = None) -> Iterator[WaveformFrame]:
+    """
+    Acquire frames back to back
+
+    Args:
+        scope: Connected RigolDHO954 instance
+        analog_channels: Analog channel numbers (1-4) to read
+        digital_channels: Digital channel numbers (0-15) to read
+        points: Number of data points per channel
+        count: Number of frames to acquire, or None to run until the consumer stops
+
+    Yields:
+        Acquired WaveformFrame objects
+    """
+    analog_channels = list(analog_channels)
+    digital_channels = list(digital_channels)
+    sequence = 0
+    while count is None or sequence < count:
+        yield acquire_frame(scope, analog_channels, digital_channels, points, sequence)
+        sequence += 1
+
+
+def load_csv_frame(filename: str, sequence: int = 0) -> WaveformFrame:
+    """
+    Load a frame from a CSV file written by the GUI's Save Data command
+
+    Columns named CH1-CH4 are read as analog channels and columns named D0-D15
+    as digital channels; relabelled digital columns are skipped.
+
+    Args:
+        filename: CSV file path
+        sequence: Frame sequence number
+
+    Returns:
+        Loaded WaveformFrame, timestamped with the file modification time
+    """
+    path = Path(filename)
+    with open(path, 'r') as f:
+        header = f.readline().strip().split(',')
+    data = np.loadtxt(path, delimiter=',', skiprows=1, ndmin=2)
+
+    frame = WaveformFrame(timestamp=path.stat().st_mtime, sequence=sequence)
+    time_data = data[:, 0]
+    for col, name in enumerate(header[1:], start=1):
+        analog = re.fullmatch(r'CH([1-4])', name)
+        digital = re.fullmatch(r'D(\d|1[0-5])', name)
+        if analog:
+            frame.analog[int(analog.group(1))] = (time_data, data[:, col])
+        elif digital:
+            frame.digital[int(digital.group(1))] = EdgeIndex.from_samples(time_data, data[:, col])
+        else:
+            logger.warning(f"Skipping unrecognised column '{name}' in {filename}")
+    return frame
+
+
+def prefetch(items: Iterable[Any], depth: int = 2) -> Iterator[Any]:
+    """
+    Produce items on a background thread while the caller consumes them
+
+    Used to overlap instrument transfers with processing; at most depth items
+    wait in the queue, so memory stays bounded.
+
+    Args:
+        items: Iterable to run on the background thread (e.g. a chunk reader)
+        depth: Maximum number of produced items not yet consumed
+
+    Yields:
+        The items, in order; exceptions raised by the producer are re-raised
+    """
+    buffer: "queue.Queue" = queue.Queue(maxsize=depth)
+    done = object()
+    stop = threading.Event()
+
+    def put(item) -> bool:
+        while not stop.is_set():
+            try:
+                buffer.put(item, timeout=0.1)
+                return True
+            except queue.Full:
+                continue
+        return False
+
+    def produce() -> None:
+        try:
+            for item in items:
+                if not put((item, None)):
+                    return
+            put((done, None))
+        except Exception as e:
+            put((done, e))
+
+    thread = threading.Thread(target=produce, daemon=True)
+    thread.start()
+    try:
+        while True:
+            item, error = buffer.get()
+            if item is done:
+                if error is not None:
+                    raise error
+                return
+            yield item
+    finally:
+        stop.set()
+        thread.join()
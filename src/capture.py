@@ -0,0 +1,325 @@
+"""
+Native binary capture files (.rcap)
+Analog channels are stored as raw ADC codes with their :WAV:PRE? scale
+factors and digital channels as packed bits, in 4 KiB aligned columns behind
+a fixed header, so a capture is written and mapped back without any parsing
+
+Layout of one frame record (offsets relative to the record start):
+    0       Header: struct HEADER (magic, version, header size, timestamp,
+            sequence, JSON length) followed by JSON with the column table and
+            the instrument settings, zero padded to a multiple of ALIGNMENT
+    ...     One column per channel at an ALIGNMENT multiple: analog codes as
+            little-endian uint8/uint16, digital levels as np.packbits bytes
+    end     Trailer: TRAILER (end magic, completion time), so truncated
+            records are detected
+
+A capture file holds one or more records, each starting at an ALIGNMENT
+multiple. Recordings keep an index sidecar (<file>.idx) of INDEX entries
+with the offset, timestamp and sequence number of every record.
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import json
+import logging
+import os
+import struct
+import time
+from typing import Any, BinaryIO, Dict, Iterable, Iterator, List, NamedTuple, Optional, Tuple
+
+import numpy as np
+
+from acquisition import RawChannel, WaveformFrame
+from edge_index import EdgeIndex
+
+logger = logging.getLogger(__name__)
+
+MAGIC = b'RGLCAP01'
+END_MAGIC = b'RGLCEND1'
+VERSION = 1
+ALIGNMENT = 4096
+HEADER = struct.Struct('<8sIIdqI')  # magic, version, header size, timestamp, sequence, JSON length
+TRAILER = struct.Struct('<8sd')  # end magic, completion timestamp
+INDEX = np.dtype([('offset', '<u8'), ('timestamp', '<f8'), ('sequence', '<i8')])
+
+
+def _align(offset: int) -> int:
+    """Next ALIGNMENT multiple at or after offset"""
+    return -(-offset // ALIGNMENT) * ALIGNMENT
+
+
+def quantize(time_data: np.ndarray, voltage: np.ndarray) -> RawChannel:
+    """
+    16-bit codes for an analog channel that was not read as codes (e.g. loaded from CSV)
+
+    The full uint16 range spans the minimum to the maximum of the channel.
+    """
+    voltage = np.asarray(voltage, dtype=np.float64)
+    n = len(voltage)
+    low = float(voltage.min()) if n else 0.0
+    span = float(voltage.max()) - low if n else 0.0
+    step = span / 65535 if span > 0 else 1.0
+    codes = np.rint((voltage - low) / step).astype(np.uint16)
+    dt = float(time_data[-1] - time_data[0]) / (n - 1) if n > 1 else 1.0
+    return RawChannel(codes, float(time_data[0]) if n else 0.0, dt, step, -low / step, 0.0)
+
+
+def write_record(f: BinaryIO, frame: WaveformFrame, settings: Optional[Dict[str, Any]] = None) -> Tuple[int, int]:
+    """
+    Append a frame record to an open capture file
+
+    The record starts at the first ALIGNMENT multiple at or after the current
+    position; columns are written straight from the code and packed bit
+    arrays.
+
+    Args:
+        f: File opened for binary writing
+        frame: WaveformFrame to write; analog channels without raw codes are
+            quantized to 16 bits
+        settings: Instrument settings stored with the frame (JSON types)
+
+    Returns:
+        Tuple of (record offset, offset after the record)
+    """
+    columns: List[Dict[str, Any]] = []
+    blocks: List[np.ndarray] = []
+    for ch in sorted(frame.analog):
+        raw = frame.raw.get(ch)
+        if raw is None:
+            raw = quantize(*frame.analog[ch])
+        codes = np.ascontiguousarray(raw.codes, dtype='<u2' if raw.codes.itemsize > 1 else np.uint8)
+        columns.append({'name': f"CH{ch}", 'kind': 'analog', 'dtype': codes.dtype.str, 'length': len(codes),
+                        'x_origin': raw.x_origin, 'x_increment': raw.x_increment,
+                        'y_increment': raw.y_increment, 'y_origin': raw.y_origin,
+                        'y_reference': raw.y_reference})
+        blocks.append(codes)
+    for d in sorted(frame.digital):
+        trace = frame.digital[d]
+        columns.append({'name': f"D{d}", 'kind': 'digital', 'dtype': '|u1', 'length': len(trace),
+                        't0': trace.t0, 'dt': trace.dt})
+        blocks.append(np.packbits(trace.to_levels()))
+
+    # The header grows in ALIGNMENT steps until the JSON fits in front of the columns
+    header_size = ALIGNMENT
+    while True:
+        offset = header_size
+        for column, block in zip(columns, blocks):
+            column['offset'] = offset
+            column['nbytes'] = block.nbytes
+            offset = _align(offset + block.nbytes)
+        text = json.dumps({'columns': columns, 'settings': settings or {}}).encode('utf-8')
+        if HEADER.size + len(text) <= header_size:
+            break
+        header_size = _align(HEADER.size + len(text))
+
+    start = _align(f.tell())
+    f.seek(start)
+    header = HEADER.pack(MAGIC, VERSION, header_size, frame.timestamp, frame.sequence, len(text)) + text
+    f.write(header.ljust(header_size, b'\0'))
+    for column, block in zip(columns, blocks):
+        f.seek(start + column['offset'])
+        f.write(memoryview(block))
+    f.seek(start + offset)
+    f.write(TRAILER.pack(END_MAGIC, time.time()))
+    return start, f.tell()
+
+
+def write_capture(filename: str, frame: WaveformFrame, settings: Optional[Dict[str, Any]] = None) -> int:
+    """
+    Write a frame as a single-record capture file
+
+    The file is written under a temporary name that is renamed when complete.
+
+    Args:
+        filename: Output .rcap path
+        frame: WaveformFrame to write
+        settings: Instrument settings stored with the capture (JSON types)
+
+    Returns:
+        File size in bytes
+    """
+    partial = f"{filename}.part"
+    try:
+        with open(partial, 'wb') as f:
+            _, size = write_record(f, frame, settings)
+        os.replace(partial, filename)
+    except BaseException:
+        if os.path.exists(partial):
+            os.remove(partial)
+        raise
+    return size
+
+
+class RecordRef(NamedTuple):
+    """Location of a frame record, e.g. of a search result in a recording"""
+
+    filename: str
+    offset: int
+    sequence: int
+
+    def __str__(self) -> str:
+        return f"{self.sequence} ({os.path.basename(self.filename)})"
+
+
+class CaptureFile:
+    """
+    Read access to a capture file
+
+    Columns are memory mapped: nothing but the header is read until a
+    column's samples are used.
+    """
+
+    def __init__(self, filename: str, offset: int = 0):
+        """
+        Open a frame record of a capture file and parse its header
+
+        Args:
+            filename: .rcap path
+            offset: Offset of the record (see read_index)
+
+        Raises:
+            ValueError: If there is no capture record at offset or it is truncated
+        """
+        self.filename = filename
+        self.offset = offset
+        size = os.path.getsize(filename)
+        with open(filename, 'rb') as f:
+            f.seek(offset)
+            fixed = f.read(HEADER.size)
+            if len(fixed) < HEADER.size:
+                raise ValueError(f"{filename} holds no capture record at {offset}")
+            magic, version, header_size, self.timestamp, self.sequence, json_length = HEADER.unpack(fixed)
+            if magic != MAGIC:
+                raise ValueError(f"{filename} holds no capture record at {offset}")
+            if version > VERSION:
+                raise ValueError(f"{filename} has capture format version {version}, newer than {VERSION}")
+            header = json.loads(f.read(json_length).decode('utf-8'))
+            end = max((c['offset'] + c['nbytes'] for c in header['columns']), default=header_size)
+            trailer_offset = offset + _align(end)
+            f.seek(trailer_offset)
+            trailer = f.read(TRAILER.size)
+        if trailer_offset + TRAILER.size > size or TRAILER.unpack(trailer)[0] != END_MAGIC:
+            raise ValueError(f"{filename} is truncated")
+        self.end = trailer_offset + TRAILER.size
+        self.columns: Dict[str, Dict[str, Any]] = {c['name']: c for c in header['columns']}
+        self.settings: Dict[str, Any] = header['settings']
+
+    @property
+    def ref(self) -> RecordRef:
+        """Location of this record"""
+        return RecordRef(self.filename, self.offset, self.sequence)
+
+    def data(self, name: str) -> np.ndarray:
+        """
+        Stored data of a column without copying
+
+        Args:
+            name: Column name (CH1-CH4, D0-D15)
+
+        Returns:
+            Read-only memory map: ADC codes of analog columns, packed bits of
+            digital columns
+        """
+        column = self.columns[name]
+        if column['nbytes'] == 0:
+            return np.empty(0, dtype=column['dtype'])
+        dtype = np.dtype(column['dtype'])
+        return np.memmap(self.filename, dtype=dtype, mode='r', offset=self.offset + column['offset'],
+                         shape=(column['nbytes'] // dtype.itemsize,))
+
+    def raw(self, ch: int) -> RawChannel:
+        """Codes and scale factors of analog channel ch"""
+        column = self.columns[f"CH{ch}"]
+        return RawChannel(self.data(f"CH{ch}"), column['x_origin'], column['x_increment'],
+                          column['y_increment'], column['y_origin'], column['y_reference'])
+
+    def digital(self, d: int) -> EdgeIndex:
+        """Edge index of digital channel d"""
+        column = self.columns[f"D{d}"]
+        levels = np.unpackbits(self.data(f"D{d}"), count=column['length'])
+        return EdgeIndex.from_levels(levels, column['t0'], column['dt'])
+
+    def frame(self) -> WaveformFrame:
+        """
+        The stored frame
+
+        Analog channels keep their codes mapped, not copied, in raw; they are
+        only scaled to volts where the frame is used.
+        """
+        frame = WaveformFrame(timestamp=self.timestamp, sequence=self.sequence)
+        for name, column in self.columns.items():
+            if column['kind'] == 'analog':
+                frame.raw[int(name[2:])] = self.raw(int(name[2:]))
+            else:
+                frame.digital[int(name[1:])] = self.digital(int(name[1:]))
+        return frame
+
+
+def scan_records(filename: str) -> np.ndarray:
+    """
+    Index of a capture file built by walking its records
+
+    Used for files without an index sidecar; a truncated last record (e.g.
+    from an interrupted recording) ends the scan.
+
+    Returns:
+        INDEX entries of the complete records
+    """
+    entries = []
+    offset, size = 0, os.path.getsize(filename)
+    while offset < size:
+        try:
+            record = CaptureFile(filename, offset)
+        except ValueError:
+            break
+        entries.append((offset, record.timestamp, record.sequence))
+        offset = _align(record.end)
+    return np.array(entries, dtype=INDEX)
+
+
+def read_index(filename: str) -> np.ndarray:
+    """
+    Record index of a capture file
+
+    Returns:
+        INDEX entries from the .idx sidecar, or from scan_records when the
+        file has none
+    """
+    sidecar = f"{filename}.idx"
+    if os.path.exists(sidecar):
+        entries = np.fromfile(sidecar, dtype=INDEX)
+        return entries[entries['offset'] < os.path.getsize(filename)]
+    return scan_records(filename)
+
+
+def read_records(filenames: Iterable[str]) -> Iterator[CaptureFile]:
+    """
+    Every indexed record of a recording, one at a time
+
+    Args:
+        filenames: Capture files in recording order
+
+    Yields:
+        CaptureFile of each record; its columns stay mapped until used
+    """
+    for filename in filenames:
+        for entry in read_index(filename):
+            yield CaptureFile(filename, int(entry['offset']))
+
+
+def read_capture(filename: str, sequence: Optional[int] = None, offset: int = 0) -> WaveformFrame:
+    """
+    Load a frame of a capture file
+
+    Args:
+        filename: .rcap path
+        sequence: Overrides the stored frame sequence number
+        offset: Offset of the record (default: the first one)
+
+    Returns:
+        Loaded WaveformFrame
+    """
+    frame = CaptureFile(filename, offset).frame()
+    if sequence is not None:
+        frame.sequence = sequence
+    return frame
@@ -25,6 +25,29 @@ class Config:
             "auto_update_rate": 2.0,
             "default_points": 1000
         },
+        "display": {
+            "fps": 30,
+            "live_view": "Matplotlib",
+            "persistence_mode": "Off",
+            "persistence_decay": "Infinite",
+            "persistence_colormap": "channel",
+            "persistence_time_bins": 500,
+            "persistence_voltage_bins": 256
+        },
+        "spectrum": {
+            "window": "Hann",
+            "averaging": "None",
+            "average_count": 16,
+            "average_alpha": 0.1,
+            "waterfall_source": "Off",
+            "waterfall_rows": 200,
+            "psd_points": 1000000,
+            "psd_segment": 65536,
+            "harmonics": 10
+        },
+        "tones": {
+            "frequencies": [50.0, 100.0, 150.0]
+        },
         "channels": {
             "default_scale": 1.0,
             "default_offset": 0.0,
@@ -44,6 +67,22 @@ class Config:
                 "D12": "D12", "D13": "D13", "D14": "D14", "D15": "D15"
             }
         },
+        "decoder": {
+            "protocol": "UART",
+            "analog_threshold": 1.4,
+            "hysteresis": 0.1
+        },
+        "search": {
+            "type": "Glitch"
+        },
+        "export": {
+            "hdf5_compression": "gzip"
+        },
+        "recording": {
+            "max_mb": 1024,
+            "max_minutes": 60,
+            "queue_depth": 16
+        },
         "timebase": {
             "default_scale": 1e-3,
             "default_offset": 0.0
@@ -0,0 +1,162 @@
+"""
+Decoded protocol results window for the RIGOL DHO954 GUI
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+import tkinter as tk
+from tkinter import ttk, messagebox, filedialog
+from typing import Callable, List, Optional
+
+from decoders import export_annotations_csv
+from utils import format_time_value
+
+logger = logging.getLogger(__name__)
+
+
+def filter_annotations(annotations: List, query: str) -> List[int]:
+    """
+    Indices of the annotations whose text, source or type contains the query
+
+    Args:
+        annotations: decoders.Annotation objects
+        query: Case-insensitive search text; empty matches everything
+
+    Returns:
+        Matching indices in order
+    """
+    query = query.strip().lower()
+    if not query:
+        return list(range(len(annotations)))
+    return [index for index, annotation in enumerate(annotations)
+            if query in annotation.text.lower() or query in annotation.lane.lower()
+            or query in annotation.kind.lower()]
+
+
+class DecoderTable:
+    """Toplevel window listing decoder annotations"""
+
+    MAX_ROWS = 5000  # Treeview insertion is the slow part; very long lists are truncated
+
+    def __init__(self, master, title: str = "Decoder Results", on_select: Optional[Callable] = None):
+        """
+        Create the (hidden until shown) results window
+
+        Args:
+            master: Parent Tk widget
+            title: Window title
+            on_select: Called with the Annotation of a row when it is selected,
+                and its frame when the rows have frames
+        """
+        self.master = master
+        self.title = title
+        self.on_select = on_select
+        self.window = None
+        self.tree = None
+        self.annotations = []
+        self.frames: Optional[List] = None  # Frame of every annotation (shown as text)
+        self.listed = []  # Indices into annotations of the rows in the table
+
+    def is_open(self) -> bool:
+        """True while the window exists"""
+        return self.window is not None and self.window.winfo_exists()
+
+    def show(self) -> None:
+        """Create the window, or raise it if it is already open"""
+        if self.is_open():
+            self.window.lift()
+            return
+
+        self.window = tk.Toplevel(self.master)
+        self.window.title(self.title)
+        self.window.geometry("520x400")
+
+        search = ttk.Frame(self.window)
+        search.pack(fill=tk.X, padx=3, pady=2)
+        ttk.Label(search, text="Search:").pack(side=tk.LEFT)
+        self.search_var = tk.StringVar(value="")
+        self.search_var.trace_add('write', lambda *args: self.populate())
+        ttk.Entry(search, textvariable=self.search_var).pack(side=tk.LEFT, fill=tk.X, expand=True, padx=3)
+
+        columns = ('frame', 'time', 'lane', 'type', 'data')
+        frame = ttk.Frame(self.window)
+        frame.pack(fill=tk.BOTH, expand=True)
+        self.tree = ttk.Treeview(frame, columns=columns, show='headings')
+        for column, heading, width in zip(columns, ('Frame', 'Time', 'Source', 'Type', 'Data'),
+                                          (140, 110, 70, 70, 250)):
+            self.tree.heading(column, text=heading)
+            self.tree.column(column, width=width, anchor=tk.W)
+        scrollbar = ttk.Scrollbar(frame, orient="vertical", command=self.tree.yview)
+        self.tree.configure(yscrollcommand=scrollbar.set)
+        self.tree.pack(side=tk.LEFT, fill=tk.BOTH, expand=True)
+        scrollbar.pack(side=tk.RIGHT, fill=tk.Y)
+        self.tree.bind('<<TreeviewSelect>>', self._on_tree_select)
+
+        bottom = ttk.Frame(self.window)
+        bottom.pack(fill=tk.X, padx=3, pady=2)
+        self.status_var = tk.StringVar(value="")
+        ttk.Label(bottom, textvariable=self.status_var).pack(side=tk.LEFT)
+        ttk.Button(bottom, text="Export CSV", command=self.export_csv).pack(side=tk.RIGHT)
+
+        self.populate()
+
+    def set_annotations(self, annotations: List, frames: Optional[List] = None) -> None:
+        """
+        Replace the listed annotations
+
+        Args:
+            annotations: decoders.Annotation objects in time order
+            frames: Frame of every annotation (a sequence number or a
+                capture.RecordRef), for results that span several frames
+                such as a searched recording
+        """
+        self.annotations = annotations
+        self.frames = frames
+        if self.is_open():
+            self.populate()
+
+    def populate(self) -> None:
+        """Fill the table from the current annotations that match the search text"""
+        self.tree.delete(*self.tree.get_children())
+        # The frame column is only shown for results that span several frames
+        self.tree.configure(displaycolumns=('time', 'lane', 'type', 'data') if self.frames is None else '#all')
+        matches = filter_annotations(self.annotations, self.search_var.get())
+        self.listed = matches[:self.MAX_ROWS]
+        for row, index in enumerate(self.listed):
+            annotation = self.annotations[index]
+            self.tree.insert('', tk.END, iid=str(row),
+                             values=('' if self.frames is None else str(self.frames[index]),
+                                     format_time_value(annotation.start), annotation.lane,
+                                     annotation.kind, annotation.text))
+        status = f"{len(matches)} items"
+        if len(matches) < len(self.annotations):
+            status += f" of {len(self.annotations)}"
+        if len(self.listed) < len(matches):
+            status += f" (first {len(self.listed)} listed)"
+        self.status_var.set(status)
+
+    def _on_tree_select(self, event) -> None:
+        """Report the selected annotation to the owner"""
+        selection = self.tree.selection()
+        if selection and self.on_select is not None:
+            index = self.listed[int(selection[0])]
+            if self.frames is None:
+                self.on_select(self.annotations[index])
+            else:
+                self.on_select(self.annotations[index], self.frames[index])
+
+    def export_csv(self) -> None:
+        """Save all annotations (not only the listed ones) to a CSV file"""
+        if not self.annotations:
+            messagebox.showwarning("Warning", "Nothing decoded to export", parent=self.window)
+            return
+        filename = filedialog.asksaveasfilename(parent=self.window, defaultextension=".csv",
+                                                filetypes=[("CSV files", "*.csv"), ("All files", "*.*")])
+        if not filename:
+            return
+        try:
+            export_annotations_csv(filename, self.annotations, self.frames)
+            logger.info(f"{len(self.annotations)} decoded items exported to {filename}")
+        except IOError as e:
+            messagebox.showerror("Error", f"Export failed: {e}", parent=self.window)
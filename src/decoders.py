@@ -0,0 +1,961 @@
+"""
+Serial protocol and parallel-bus decoders for RIGOL DHO954 logic-analyzer and analog captures
+Decoders work on edge-indexed traces: edges come precomputed and levels are
+looked up by binary search; Python only loops once per decoded word, never
+once per sample
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import csv
+import logging
+import re
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Sequence, Tuple, Union
+
+import numpy as np
+
+from edge_index import EdgeIndex
+
+logger = logging.getLogger(__name__)
+
+# Analog-to-logic threshold: one level in volts or (falling, rising) levels
+Threshold = Union[float, Tuple[float, float]]
+
+
+@dataclass
+class Annotation:
+    """One decoded item, spanning [start, end] seconds on a source lane"""
+    start: float
+    end: float
+    text: str
+    lane: str
+    kind: str = 'data'  # 'data', 'address', 'control', 'crc', 'start', 'stop', 'ack', 'nack' or 'error'
+    value: Optional[int] = None
+
+
+@dataclass
+class Parameter:
+    """A decoder setting shown in the GUI"""
+    key: str
+    label: str
+    default: str
+    choices: Optional[Sequence[str]] = None
+    channel: bool = False  # Value is a source channel ('D0'-'D15' or 'CH1'-'CH4')
+    optional: bool = False  # Channel may be 'None'
+
+
+def get_logic_trace(frame, source: str, threshold: Threshold = 1.4) -> EdgeIndex:
+    """
+    Get a channel of a frame as a logic trace
+
+    Args:
+        frame: WaveformFrame holding the channel
+        source: 'D0'-'D15' for logic-analyzer channels, 'CH1'-'CH4' for
+            analog channels, which go through a comparator
+        threshold: Comparator level in volts, or (falling, rising) levels
+            for a comparator with hysteresis
+
+    Returns:
+        Edge index of the channel (the frame's own one for digital channels)
+    """
+    if source.startswith('D'):
+        d = int(source[1:])
+        if d not in frame.digital:
+            raise ValueError(f"{source} is not in the captured frame")
+        return frame.digital[d]
+    if source.startswith('CH'):
+        ch = int(source[2:])
+        if ch not in frame.analog:
+            raise ValueError(f"{source} is not in the captured frame")
+        falling, rising = (threshold, threshold) if np.isscalar(threshold) else threshold
+        raw = frame.raw_channel(ch)
+        if raw is not None:
+            # Compare the codes against the thresholds in code units instead of converting to volts
+            return EdgeIndex.from_analog(raw.time_range(), raw.codes, raw.to_codes(falling), raw.to_codes(rising))
+        time_data, voltage_data = frame.analog[ch]
+        return EdgeIndex.from_analog(time_data, voltage_data, falling, rising)
+    raise ValueError(f"Unknown source '{source}'")
+
+
+def frame_duration(frame) -> float:
+    """Time span of the longest channel in a frame"""
+    spans = [last - first for first, last in map(frame.analog.time_range, frame.analog)]
+    spans += [edges.duration for edges in frame.digital.values()]
+    return max(spans, default=0.0)
+
+
+def export_annotations_csv(filename: str, annotations: Sequence[Annotation],
+                           frames: Optional[Sequence] = None) -> None:
+    """
+    Write annotations to a CSV file
+
+    Args:
+        filename: Output CSV path
+        annotations: Annotations to write
+        frames: Frame of every annotation (e.g. its sequence number),
+            written as a leading Frame column
+    """
+    with open(filename, 'w', newline='') as f:
+        writer = csv.writer(f)
+        header = ['Start', 'End', 'Source', 'Type', 'Value', 'Text']
+        writer.writerow(header if frames is None else ['Frame'] + header)
+        for index, a in enumerate(annotations):
+            row = [f"{a.start:.9e}", f"{a.end:.9e}", a.lane, a.kind, '' if a.value is None else a.value, a.text]
+            writer.writerow(row if frames is None else [frames[index]] + row)
+
+
+def transitions(bits: np.ndarray) -> np.ndarray:
+    """Indices of the first sample of every new logic level"""
+    return np.flatnonzero(np.diff(bits)) + 1
+
+
+def sample_interval(trace: EdgeIndex) -> float:
+    """Time between samples of a logic trace"""
+    if len(trace) < 2:
+        raise ValueError("Need at least two samples to decode")
+    return trace.dt
+
+
+def parse_sources(text: str) -> List[str]:
+    """
+    Expand a source list such as 'D0-D3, D7, CH1' into single sources
+
+    Args:
+        text: Comma-separated sources; 'Dn-Dm' ranges are allowed
+
+    Returns:
+        Source names in the given order
+    """
+    sources = []
+    for item in re.split(r'[,\s]+', text.strip()):
+        if not item:
+            continue
+        span = re.fullmatch(r'D(\d+)-D?(\d+)', item, re.IGNORECASE)
+        if span:
+            first, last = int(span.group(1)), int(span.group(2))
+            step = 1 if last >= first else -1
+            sources.extend(f"D{d}" for d in range(first, last + step, step))
+        else:
+            sources.append(item.upper())
+    return sources
+
+
+def pack_bus(bits: Sequence[EdgeIndex]) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Pack logic traces into bus values at every change of any bit
+
+    The bus only changes at the edges of its bits, so the union of their edges
+    splits the record into constant segments whose values are packed with one
+    vectorized state lookup per bit.
+
+    Args:
+        bits: Traces on one sample grid, bit 0 first
+
+    Returns:
+        Tuple of (segment start sample indices, values)
+    """
+    if not bits:
+        raise ValueError("A bus needs at least one bit")
+    if any(len(trace) != len(bits[0]) or trace.dt != bits[0].dt for trace in bits):
+        raise ValueError("Bus bits must share one sample grid")
+    points = np.unique(np.concatenate([np.zeros(1, dtype=np.int64)] + [trace.edges for trace in bits]))
+    values = np.zeros(len(points), dtype=np.int64)
+    for bit, trace in enumerate(bits):
+        values |= trace.state_at_index(points).astype(np.int64) << bit
+    return points, values
+
+
+def chain_starts(candidates: np.ndarray, min_gap: float) -> np.ndarray:
+    """
+    Greedily pick frame start candidates that are at least min_gap apart
+
+    The successor of every candidate is found in one vectorized searchsorted
+    call; following the chain then costs one step per decoded frame.
+
+    Args:
+        candidates: Sorted candidate start sample indices
+        min_gap: Minimum distance in samples to the next frame start
+
+    Returns:
+        Selected start indices
+    """
+    if len(candidates) == 0:
+        return candidates
+    successor = np.searchsorted(candidates, candidates + min_gap)
+    selected = []
+    i = 0
+    while i < len(candidates):
+        selected.append(i)
+        i = successor[i]
+    return candidates[selected]
+
+
+class Decoder:
+    """Base class for protocol decoders"""
+
+    name = ''
+    parameters: List[Parameter] = []
+
+    def decode(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """
+        Decode a frame
+
+        Args:
+            frame: WaveformFrame to decode
+            settings: Parameter values keyed by Parameter.key
+            threshold: Comparator level(s) for analog sources (see get_logic_trace)
+
+        Returns:
+            Annotations in time order
+        """
+        raise NotImplementedError
+
+    def statistics(self, annotations: List[Annotation], duration: float) -> Dict[str, float]:
+        """
+        Summary figures for the measurements panel
+
+        Args:
+            annotations: Result of decode()
+            duration: Length of the decoded capture in seconds
+
+        Returns:
+            Values keyed by display name (none by default)
+        """
+        return {}
+
+
+def _printable(value: int) -> str:
+    """Hex value plus the ASCII character when it is printable"""
+    text = f"0x{value:02X}"
+    if 32 <= value < 127:
+        text += f" '{chr(value)}'"
+    return text
+
+
+class UartDecoder(Decoder):
+    """Asynchronous serial (UART) decoder"""
+
+    name = 'UART'
+    parameters = [
+        Parameter('rx', 'RX', 'D0', channel=True),
+        Parameter('baud', 'Baud', '115200', ['9600', '19200', '38400', '57600', '115200',
+                                              '230400', '460800', '921600', '1000000']),
+        Parameter('data_bits', 'Data bits', '8', ['5', '6', '7', '8', '9']),
+        Parameter('parity', 'Parity', 'None', ['None', 'Even', 'Odd']),
+        Parameter('stop_bits', 'Stop bits', '1', ['1', '2']),
+        Parameter('idle', 'Idle', 'High', ['High', 'Low']),
+    ]
+
+    def decode(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Decode UART words (LSB first) on the RX source"""
+        source = settings['rx']
+        trace = get_logic_trace(frame, source, threshold)
+        return decode_uart(trace, float(settings['baud']), int(settings['data_bits']),
+                           settings['parity'], int(settings['stop_bits']), settings['idle'] == 'High', source)
+
+
+def decode_uart(trace: EdgeIndex, baud: float, data_bits: int = 8,
+                parity: str = 'None', stop_bits: int = 1, idle_high: bool = True,
+                lane: str = 'RX') -> List[Annotation]:
+    """
+    Decode a UART logic trace
+
+    Start bits are the idle-to-active transitions that are still active at
+    the middle of the bit and not inside a previous word; all bits of all words are then sampled at their centres
+    with a single fancy-indexing operation.
+
+    Args:
+        trace: RX logic trace
+        baud: Bit rate in bits per second
+        data_bits: Data bits per word (5-9)
+        parity: 'None', 'Even' or 'Odd'
+        stop_bits: Stop bits per word (1 or 2)
+        idle_high: Line idles high (standard UART); False for inverted lines
+        lane: Lane name put on the annotations
+
+    Returns:
+        One annotation per word; words with a bad parity or stop bit are
+        marked as errors, glitches that fail the start bit check are skipped
+        without hiding a start bit that follows them
+    """
+    dt = sample_interval(trace)
+    samples_per_bit = 1.0 / (baud * dt)
+    if samples_per_bit < 3:
+        raise ValueError(f"Sample rate too low for {baud:g} baud (need 3 samples per bit)")
+    if parity not in ('None', 'Even', 'Odd'):
+        raise ValueError("Parity must be 'None', 'Even' or 'Odd'")
+
+    level = trace if idle_high else trace.inverted()
+    starts = level.falling()
+    word_bits = 1 + data_bits + (parity != 'None') + stop_bits
+
+    # Glitches are dropped before chaining, so they cannot swallow the word after them
+    start_centres = starts + int(0.5 * samples_per_bit)
+    valid = start_centres < len(level)
+    starts, start_centres = starts[valid], start_centres[valid]
+    starts = starts[level.state_at_index(start_centres) == 0]
+
+    # Next start bit may begin once the middle of the last stop bit has passed
+    starts = chain_starts(starts, (word_bits - 0.5) * samples_per_bit)
+    centres = starts[:, None] + ((np.arange(word_bits) + 0.5) * samples_per_bit).astype(np.intp)
+    complete = centres[:, -1] < len(level)
+    starts, centres = starts[complete], centres[complete]
+    if len(starts) == 0:
+        return []
+
+    sampled = level.state_at_index(centres)
+    data = sampled[:, 1:1 + data_bits].astype(np.int64)
+    values = data @ (1 << np.arange(data_bits, dtype=np.int64))  # LSB first
+    parity_ok = np.ones(len(starts), dtype=bool)
+    if parity != 'None':
+        ones = data.sum(axis=1) + sampled[:, 1 + data_bits]
+        parity_ok = (ones % 2) == (0 if parity == 'Even' else 1)
+    stop_ok = sampled[:, word_bits - stop_bits:].all(axis=1)
+
+    t0 = level.t0
+    begin = t0 + starts * dt
+    end = begin + word_bits * samples_per_bit * dt
+    annotations = []
+    for i in range(len(starts)):
+        value = int(values[i])
+        if not stop_ok[i]:
+            annotations.append(Annotation(begin[i], end[i], f"{_printable(value)} framing error", lane, 'error', value))
+        elif not parity_ok[i]:
+            annotations.append(Annotation(begin[i], end[i], f"{_printable(value)} parity error", lane, 'error', value))
+        else:
+            annotations.append(Annotation(begin[i], end[i], _printable(value), lane, 'data', value))
+    return annotations
+
+
+class SpiDecoder(Decoder):
+    """SPI decoder (any CPOL/CPHA, optional MISO and chip select)"""
+
+    name = 'SPI'
+    parameters = [
+        Parameter('clk', 'CLK', 'D0', channel=True),
+        Parameter('mosi', 'MOSI', 'D1', channel=True, optional=True),
+        Parameter('miso', 'MISO', 'None', channel=True, optional=True),
+        Parameter('cs', 'CS', 'None', channel=True, optional=True),
+        Parameter('cpol', 'CPOL', '0', ['0', '1']),
+        Parameter('cpha', 'CPHA', '0', ['0', '1']),
+        Parameter('word_bits', 'Word bits', '8', ['4', '8', '12', '16', '24', '32']),
+        Parameter('bit_order', 'Bit order', 'MSB first', ['MSB first', 'LSB first']),
+        Parameter('cs_polarity', 'CS active', 'Low', ['Low', 'High']),
+    ]
+
+    def decode(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Decode SPI words on MOSI and/or MISO"""
+        clk = get_logic_trace(frame, settings['clk'], threshold)
+        data_lines = {}
+        for key in ('mosi', 'miso'):
+            if settings[key] != 'None':
+                data_lines[settings[key]] = get_logic_trace(frame, settings[key], threshold)
+        if not data_lines:
+            raise ValueError("Assign MOSI and/or MISO")
+        cs = None
+        if settings['cs'] != 'None':
+            cs = get_logic_trace(frame, settings['cs'], threshold)
+            if settings['cs_polarity'] == 'High':
+                cs = cs.inverted()
+        return decode_spi(clk, data_lines, cs, int(settings['cpol']), int(settings['cpha']),
+                          int(settings['word_bits']), settings['bit_order'] == 'MSB first')
+
+
+def decode_spi(clk: EdgeIndex, data_lines: Dict[str, EdgeIndex], cs: Optional[EdgeIndex] = None, cpol: int = 0, cpha: int = 0, word_bits: int = 8,
+               msb_first: bool = True) -> List[Annotation]:
+    """
+    Decode SPI words
+
+    Data is sampled on the clock edges selected by CPOL/CPHA (rising when
+    they are equal, falling otherwise). Bit positions restart at every chip
+    select assertion, or, without chip select, after a clock pause longer
+    than ten bit periods. Words are assembled for all lines at once with
+    np.add.reduceat.
+
+    Args:
+        clk: Clock logic trace
+        data_lines: Data logic traces keyed by lane name (e.g. MOSI and MISO sources)
+        cs: Chip select trace, active low (None if not connected)
+        cpol: Clock idle level
+        cpha: 0 to sample on the leading edge, 1 on the trailing edge
+        word_bits: Bits per word
+        msb_first: Most significant bit is sent first
+
+    Returns:
+        One annotation per word and line, in time order
+    """
+    if word_bits < 1 or word_bits > 62:
+        raise ValueError("Word size must be 1-62 bits")
+    dt = sample_interval(clk)
+    edges = clk.rising() if cpol == cpha else clk.falling()
+
+    if cs is not None:
+        edges = edges[cs.state_at_index(edges) == 0]
+        frame_starts = cs.falling()
+        segment = np.searchsorted(frame_starts, edges, side='right')
+    else:
+        gaps = np.diff(edges)
+        pause = 10 * np.median(gaps) if len(gaps) else 0
+        segment = np.concatenate([[0], np.cumsum(gaps > pause)])
+    if len(edges) == 0:
+        return []
+
+    # Position of every edge inside its segment, then inside its word
+    first = np.flatnonzero(np.concatenate([[True], segment[1:] != segment[:-1]]))
+    position = np.arange(len(edges)) - np.repeat(first, np.diff(np.append(first, len(edges))))
+    bit = position % word_bits
+    word_id = segment.astype(np.int64) * (len(edges) + 1) + position // word_bits
+
+    # Keep only complete words
+    word_start = np.flatnonzero(np.concatenate([[True], word_id[1:] != word_id[:-1]]))
+    word_length = np.diff(np.append(word_start, len(edges)))
+    complete = np.repeat(word_length == word_bits, word_length)
+    edges, bit = edges[complete], bit[complete]
+    word_start = np.flatnonzero(bit == 0)
+    if len(word_start) == 0:
+        return []
+    shift = (word_bits - 1 - bit) if msb_first else bit
+
+    t0 = clk.t0
+    begin = t0 + edges[word_start] * dt
+    end = t0 + edges[word_start + word_bits - 1] * dt
+    annotations = []
+    for lane, line in data_lines.items():
+        values = np.add.reduceat(line.state_at_index(edges).astype(np.int64) << shift, word_start)
+        digits = (word_bits + 3) // 4
+        annotations.extend(Annotation(b, e, f"0x{int(v):0{digits}X}", lane, 'data', int(v))
+                           for b, e, v in zip(begin, end, values))
+    annotations.sort(key=lambda a: a.start)
+    return annotations
+
+
+class I2cDecoder(Decoder):
+    """I2C decoder with START/STOP, address, R/W, data and ACK/NACK"""
+
+    name = 'I2C'
+    parameters = [
+        Parameter('scl', 'SCL', 'D0', channel=True),
+        Parameter('sda', 'SDA', 'D1', channel=True),
+    ]
+
+    def decode(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Decode I2C transfers"""
+        scl = get_logic_trace(frame, settings['scl'], threshold)
+        sda = get_logic_trace(frame, settings['sda'], threshold)
+        return decode_i2c(scl, sda, settings['sda'])
+
+
+def decode_i2c(scl: EdgeIndex, sda: EdgeIndex, lane: str = 'SDA') -> List[Annotation]:
+    """
+    Decode I2C transfers
+
+    SDA edges while SCL is high are START (falling) and STOP (rising)
+    conditions; every other SCL rising edge samples one bit. Bits are split into
+    9-bit groups (8 data bits, MSB first, plus ACK) between consecutive
+    conditions, all with array operations.
+
+    Flagged as errors: bits before the first START or after a STOP,
+    incomplete bytes cut off by a condition, and a STOP directly after
+    another STOP.
+
+    Args:
+        scl: SCL logic trace
+        sda: SDA logic trace
+        lane: Lane name put on the annotations
+
+    Returns:
+        Annotations in time order
+    """
+    dt = sample_interval(sda)
+    t0 = sda.t0
+
+    while_high = scl.state_at_index(sda.edges) == 1
+    sda_edges = sda.edges[while_high]
+    is_start = sda.edge_levels()[while_high] == 0
+    bit_edges = scl.rising()
+    scl_falls = scl.falling()
+    # An SCL high phase that ends in a condition (the setup of Sr or P) carries no bit
+    never = len(scl) + 1
+    next_fall = np.append(scl_falls, never)[np.searchsorted(scl_falls, bit_edges)]
+    next_condition = np.append(sda_edges, never)[np.searchsorted(sda_edges, bit_edges)]
+    bit_edges = bit_edges[next_condition >= next_fall]
+
+    annotations = []
+    # A START after a START is a repeated START; a STOP after a STOP closes nothing
+    previous_start = np.concatenate([[False], is_start[:-1]])
+    previous_stop = np.concatenate([[False], ~is_start[:-1]])
+    for index, start, after_start, after_stop in zip(sda_edges, is_start, previous_start, previous_stop):
+        t = t0 + index * dt
+        if start:
+            annotations.append(Annotation(t, t, 'Sr' if after_start else 'S', lane, 'start'))
+        elif after_stop:
+            annotations.append(Annotation(t, t, 'P without START', lane, 'error'))
+        else:
+            annotations.append(Annotation(t, t, 'P', lane, 'stop'))
+
+    if len(bit_edges):
+        # Segment k holds the bits after the k-th condition (0: before any condition)
+        segment = np.searchsorted(sda_edges, bit_edges)
+        opened_by_start = np.concatenate([[False], is_start])[segment]
+        orphan = ~opened_by_start
+        if orphan.any():
+            for k in np.unique(segment[orphan]):
+                members = bit_edges[segment == k]
+                annotations.append(Annotation(t0 + members[0] * dt, t0 + members[-1] * dt,
+                                              f"{len(members)} bits without START", lane, 'error'))
+        bit_edges, segment = bit_edges[opened_by_start], segment[opened_by_start]
+
+    if len(bit_edges):
+        first = np.flatnonzero(np.concatenate([[True], segment[1:] != segment[:-1]]))
+        counts = np.diff(np.append(first, len(bit_edges)))
+        position = np.arange(len(bit_edges)) - np.repeat(first, counts)
+        byte_index = position // 9
+        bit = position % 9
+        bits = sda.state_at_index(bit_edges).astype(np.int64)
+
+        # Complete 9-bit groups only; a cut-off group is a protocol error
+        group_id = segment.astype(np.int64) * (len(bit_edges) + 1) + byte_index
+        group_start = np.flatnonzero(np.concatenate([[True], group_id[1:] != group_id[:-1]]))
+        group_length = np.diff(np.append(group_start, len(bit_edges)))
+        for g, n in zip(group_start[group_length != 9], group_length[group_length != 9]):
+            annotations.append(Annotation(t0 + bit_edges[g] * dt, t0 + bit_edges[g + n - 1] * dt,
+                                          f"Incomplete byte ({n} bits)", lane, 'error'))
+        complete = np.repeat(group_length == 9, group_length)
+        starts = group_start[group_length == 9]
+        data_bits = complete & (bit < 8)
+        values = np.add.reduceat(np.where(data_bits, bits << np.clip(7 - bit, 0, 7), 0), starts) \
+            if len(starts) else np.empty(0, dtype=np.int64)
+        acks = bits[starts + 8] == 0 if len(starts) else np.empty(0, dtype=bool)
+        is_address = byte_index[starts] == 0
+
+        for g, value, ack, address in zip(starts, values, acks, is_address):
+            begin, last = t0 + bit_edges[g] * dt, t0 + bit_edges[g + 7] * dt
+            ack_time = t0 + bit_edges[g + 8] * dt
+            value = int(value)
+            if address:
+                text = f"Addr 0x{value >> 1:02X} {'R' if value & 1 else 'W'}"
+                annotations.append(Annotation(begin, last, text, lane, 'address', value))
+            else:
+                annotations.append(Annotation(begin, last, f"0x{value:02X}", lane, 'data', value))
+            annotations.append(Annotation(ack_time, ack_time, 'ACK' if ack else 'NACK', lane,
+                                          'ack' if ack else 'nack'))
+
+    annotations.sort(key=lambda a: a.start)
+    return annotations
+
+
+# CAN FD payload length of every DLC code
+CAN_FD_LENGTHS = [0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64]
+
+# (width, polynomial, initial value) of the classic, short FD and long FD CRCs
+CAN_CRC15 = (15, 0x4599, 0)
+CAN_CRC17 = (17, 0x1685B, 1 << 16)
+CAN_CRC21 = (21, 0x102899, 1 << 20)
+
+_crc_powers: Dict[Tuple[int, int], np.ndarray] = {}
+
+
+def can_crc(bits: np.ndarray, crc: Tuple[int, int, int]) -> int:
+    """
+    CRC of a bit sequence (MSB-first shift register)
+
+    The remainder is linear in the message bits, so it is the XOR of the
+    precomputed x^k mod P terms of the set bits instead of a per-bit loop.
+
+    Args:
+        bits: Message bits, first transmitted first
+        crc: (width, polynomial, initial value), e.g. CAN_CRC15
+
+    Returns:
+        CRC value
+    """
+    width, poly, init = crc
+    n = len(bits)
+    powers = _crc_powers.get((width, poly))
+    if powers is None or len(powers) < n + width:
+        count = max(2048, n + width)
+        powers = np.empty(count, dtype=np.int64)
+        value = 1
+        for k in range(count):
+            powers[k] = value
+            value <<= 1
+            if value >> width:
+                value ^= poly | (1 << width)
+        _crc_powers[(width, poly)] = powers
+    # Remainder of (message * x^width + init * x^n) mod P
+    ones = np.flatnonzero(bits)
+    terms = powers[n - 1 - ones + width]
+    result = int(np.bitwise_xor.reduce(terms)) if len(terms) else 0
+    for j in range(width):
+        if (init >> j) & 1:
+            result ^= int(powers[j + n])
+    return result
+
+
+def sample_bits(trace: EdgeIndex, begin: int, end: int, bit_samples: float,
+                sample_point: float = 0.75) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Recover NRZ bits, resynchronizing the bit clock on every edge
+
+    Each run between edges holds as many bits as it has sample points, so
+    the whole range is converted with a handful of array operations.
+
+    Args:
+        trace: Logic trace
+        begin: Sample index of a bit boundary where recovery starts
+        end: Sample index where recovery stops
+        bit_samples: Nominal bit time in samples
+        sample_point: Position of the sample point within a bit (0-1)
+
+    Returns:
+        Tuple of (bit values, start sample of every bit as float)
+    """
+    end = min(end, len(trace))
+    if end <= begin:
+        return np.empty(0, dtype=np.uint8), np.empty(0)
+    bounds = np.concatenate([[begin], trace.edges_in(begin + 1, end), [end]])
+    lengths = np.diff(bounds)
+    counts = np.maximum(np.ceil(lengths / bit_samples - sample_point), 0).astype(np.intp)
+    first = np.repeat(bounds[:-1], counts)
+    offset = np.arange(counts.sum()) - np.repeat(np.cumsum(counts) - counts, counts)
+    return trace.state_at_index(first), first + offset * bit_samples
+
+
+def destuff(raw: np.ndarray) -> Tuple[np.ndarray, np.ndarray, int]:
+    """
+    Locate CAN stuff bits: the bit after five equal bits is an opposite stuff bit
+
+    A stuff bit starts the next run, so in a valid stream every run is at most
+    five bits long and each five-bit run is followed by a stuff bit.
+
+    Args:
+        raw: Bits as sent, starting at SOF
+
+    Returns:
+        Tuple of (raw indices of the data bits, raw indices of the stuff bits,
+        raw index of the first stuff error or len(raw)); only bits before the
+        error are returned
+    """
+    bounds = np.concatenate([[0], transitions(raw), [len(raw)]])
+    lengths = np.diff(bounds)
+    too_long = np.flatnonzero(lengths > 5)
+    error = int(bounds[too_long[0]] + 5) if len(too_long) else len(raw)
+    stuffed = bounds[1:-1][lengths[:-1] == 5]
+    stuffed = stuffed[stuffed < error]
+    data = np.ones(error, dtype=bool)
+    data[stuffed] = False
+    return np.flatnonzero(data), stuffed, error
+
+
+def estimate_bit_samples(trace: EdgeIndex) -> float:
+    """Bit time in samples from the shortest runs between edges"""
+    lengths = np.diff(trace.edges)
+    if len(lengths) == 0:
+        raise ValueError("Not enough edges to recover the bit rate")
+    shortest = np.percentile(lengths, 5)
+    return float(np.median(lengths[(lengths >= 0.5 * shortest) & (lengths <= 1.5 * shortest)]))
+
+
+class CanDecoder(Decoder):
+    """CAN 2.0 and CAN FD decoder with bit (de)stuffing and CRC checks"""
+
+    name = 'CAN'
+    parameters = [
+        Parameter('can', 'Source', 'CH1', channel=True),
+        Parameter('signal', 'Signal', 'CAN_H', ['CAN_H', 'CAN_L', 'RX/TX']),
+        Parameter('bitrate', 'Bit rate', '500000', ['Auto', '125000', '250000', '500000', '1000000']),
+        Parameter('data_bitrate', 'FD data rate', '2000000', ['1000000', '2000000', '4000000',
+                                                              '5000000', '8000000']),
+        Parameter('sample_point', 'Sample pt %', '75', ['60', '70', '75', '80', '87.5']),
+    ]
+
+    def decode(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Decode CAN frames; CAN_H is high and CAN_L / RX low while dominant"""
+        source = settings['can']
+        trace = get_logic_trace(frame, source, threshold)
+        bitrate = None if settings['bitrate'] == 'Auto' else float(settings['bitrate'])
+        return decode_can(trace, bitrate, float(settings['data_bitrate']),
+                          float(settings['sample_point']) / 100, settings['signal'] == 'CAN_H', source)
+
+    def statistics(self, annotations: List[Annotation], duration: float) -> Dict[str, float]:
+        """Frame rate, error frames and bus load (time between SOF and end of EOF)"""
+        if duration <= 0:
+            return {}
+        frames = sum(1 for a in annotations if a.kind == 'address')
+        errors = sum(1 for a in annotations if a.kind == 'error')
+        sof = np.array([a.start for a in annotations if a.kind == 'start'])
+        eof = np.array([a.end for a in annotations if a.kind == 'stop'])
+        busy = 0.0
+        if len(sof) and len(eof):
+            owner = np.searchsorted(sof, eof) - 1
+            busy = float(np.sum(eof[owner >= 0] - sof[owner[owner >= 0]]))
+        return {'Frames/s': frames / duration, 'Error frames': errors, 'Bus load %': 100 * busy / duration}
+
+
+def decode_can(trace: EdgeIndex, bitrate: Optional[float] = 500e3,
+               data_bitrate: Optional[float] = None, sample_point: float = 0.75,
+               dominant_high: bool = True, lane: str = 'CAN') -> List[Annotation]:
+    """
+    Decode CAN 2.0 (base and extended) and CAN FD frames
+
+    Bits are recovered for the whole capture at once by counting the sample
+    points in every run between edges (hard resynchronization on each edge).
+    A start of frame is a dominant bit after at least ten recessive bits;
+    each frame is then destuffed, parsed and CRC-checked with array
+    operations. CAN FD data phases with a bit-rate switch are re-sampled at
+    the data bit rate from the BRS sample point to the CRC delimiter.
+
+    Args:
+        trace: Logic trace of the bus
+        bitrate: Nominal (arbitration) bit rate; None estimates it from the edges
+        data_bitrate: CAN FD data-phase bit rate (defaults to the nominal rate)
+        sample_point: Sample point as a fraction of the bit time
+        dominant_high: Dominant is the high level (CAN_H); False for CAN_L or RX
+        lane: Lane name put on the annotations
+
+    Returns:
+        Annotations in time order: SOF, ID, DLC, data bytes, CRC, ACK and EOF
+        per frame; stuff, form, CRC and stuff-count errors end a frame with an
+        error annotation
+    """
+    dt = sample_interval(trace)
+    t0 = trace.t0
+    rx = trace.inverted() if dominant_high else trace  # 1 = recessive
+    bit_samples = estimate_bit_samples(rx) if bitrate is None else 1.0 / (bitrate * dt)
+    data_samples = bit_samples if not data_bitrate else 1.0 / (data_bitrate * dt)
+    if min(bit_samples, data_samples) < 3:
+        raise ValueError("Sample rate too low for the CAN bit rate (need 3 samples per bit)")
+
+    bits, starts = sample_bits(rx, 0, len(rx), bit_samples, sample_point)
+    bounds = np.concatenate([[0], transitions(bits), [len(bits)]])
+    lengths = np.diff(bounds)
+    idle = (bits[bounds[:-2]] == 1) & (lengths[:-1] >= 10)
+    sofs = bounds[1:-1][idle]
+
+    annotations = []
+    for sof in sofs:
+        annotations.extend(_decode_can_frame(rx, bits, starts, int(sof), bit_samples, data_samples,
+                                             sample_point, t0, dt, lane))
+    return annotations
+
+
+def _decode_can_frame(rx: EdgeIndex, bits: np.ndarray, starts: np.ndarray, sof: int,
+                      bit_samples: float, data_samples: float, sample_point: float,
+                      t0: float, dt: float, lane: str) -> List[Annotation]:
+    """Decode the CAN frame starting at nominal bit index sof (see decode_can)"""
+    raw = bits[sof:sof + 720]
+    begin = starts[sof:sof + 720]
+    width = np.full(len(raw), bit_samples)
+    data, stuffed, error = destuff(raw)
+    annotations = []
+
+    def span(first: int, last: int) -> Tuple[float, float]:
+        """Time span of raw bits first..last"""
+        return t0 + begin[first] * dt, t0 + (begin[last] + width[last]) * dt
+
+    def field(a: int, b: int) -> int:
+        """Value of destuffed bits a..b-1, MSB first"""
+        return int(raw[data[a:b]].astype(np.int64) @ (1 << np.arange(b - a - 1, -1, -1, dtype=np.int64)))
+
+    def fail(text: str, at: int) -> List[Annotation]:
+        """End the frame with an error at raw bit index at"""
+        annotations.append(Annotation(*span(at, at), text, lane, 'error'))
+        return annotations
+
+    def need(count: int) -> bool:
+        """True when count destuffed bits are available"""
+        return len(data) >= count
+
+    def cut() -> List[Annotation]:
+        """End the frame at a stuff error, or quietly when the capture ends inside it"""
+        return fail("Stuff error", error) if error < len(raw) else annotations
+
+    if not need(19):
+        return cut()
+    annotations.append(Annotation(*span(0, 0), 'SOF', lane, 'start'))
+
+    extended = bool(raw[data[13]])
+    if extended:
+        if not need(39):
+            return cut()
+        identifier = (field(1, 12) << 18) | field(14, 32)
+        remote, fd, control = bool(raw[data[32]]), bool(raw[data[33]]), 34
+        id_end = 32
+    else:
+        identifier = field(1, 12)
+        remote, fd, control = bool(raw[data[12]]), bool(raw[data[14]]), 15
+        id_end = 12
+    # Classic frames: r0 (and r1) then DLC; FD frames: res, BRS, ESI, then DLC
+    if not fd:
+        control += int(extended)
+    brs = False
+    if fd:
+        if not need(control + 7):
+            return cut()
+        brs = bool(raw[data[control + 1]])
+        control += 3
+    text = f"ID 0x{identifier:08X}" if extended else f"ID 0x{identifier:03X}"
+    if remote and not fd:
+        text += " RTR"
+    annotations.append(Annotation(*span(1, data[id_end]), text, lane, 'address', identifier))
+
+    if brs:
+        # Switch to the data bit time at the BRS sample point
+        brs_bit = data[control - 2]
+        switch = begin[brs_bit] + sample_point * bit_samples + (1 - sample_point) * data_samples
+        fast, fast_begin = sample_bits(rx, int(round(switch)), int(switch + 720 * data_samples),
+                                       data_samples, sample_point)
+        raw = np.concatenate([raw[:brs_bit + 1], fast])
+        begin = np.concatenate([begin[:brs_bit + 1], fast_begin])
+        width = np.concatenate([width[:brs_bit + 1], np.full(len(fast), data_samples)])
+        width[brs_bit] = switch - begin[brs_bit]
+        data, stuffed, error = destuff(raw)
+
+    if not need(control + 4):
+        return cut()
+    esi = fd and bool(raw[data[control - 1]])
+    dlc = field(control, control + 4)
+    length = CAN_FD_LENGTHS[dlc] if fd else (0 if remote else min(dlc, 8))
+    text = f"DLC {dlc}" if length == dlc or (remote and not fd) else f"DLC {dlc} ({length} bytes)"
+    if fd:
+        text += " FD" + " BRS" * brs + " ESI" * esi
+    annotations.append(Annotation(*span(data[control], data[control + 3]), text, lane, 'control', dlc))
+
+    payload = control + 4
+    crc_at = payload + 8 * length
+    if not need(crc_at + (0 if fd else 15)):
+        return cut()
+    for k in range(length):
+        value = field(payload + 8 * k, payload + 8 * k + 8)
+        annotations.append(Annotation(*span(data[payload + 8 * k], data[payload + 8 * k + 7]),
+                                      f"0x{value:02X}", lane, 'data', value))
+
+    if fd:
+        # Fixed stuff bits before the stuff count and every fourth CRC field bit after it
+        last = int(data[crc_at - 1])
+        crc = CAN_CRC17 if length <= 16 else CAN_CRC21
+        field_bits = 4 + crc[0]
+        fixed_count = (field_bits + 3) // 4
+        fixed = last + 1 + 5 * np.arange(fixed_count)
+        delimiter = last + 1 + field_bits + fixed_count
+        if delimiter >= len(raw):
+            return annotations
+        wrong = fixed[raw[fixed] == raw[fixed - 1]]
+        if len(wrong):
+            return fail("Fixed stuff error", int(wrong[0]))
+        crc_field = np.setdiff1d(np.arange(last + 1, delimiter), fixed)
+        values = raw[crc_field].astype(np.int64)
+        gray = int(values[0]) << 2 | int(values[1]) << 1 | int(values[2])
+        count = gray ^ (gray >> 1) ^ (gray >> 2)
+        if (values[:4].sum() % 2) or count != (last - (crc_at - 1)) % 8:
+            return fail("Stuff count error", int(crc_field[3]))
+        received = int(values[4:] @ (1 << np.arange(crc[0] - 1, -1, -1, dtype=np.int64)))
+        computed = can_crc(np.concatenate([raw[:last + 1], raw[crc_field[:4]]]), crc)
+        crc_first = int(crc_field[0])
+    else:
+        crc = CAN_CRC15
+        received = field(crc_at, crc_at + 15)
+        computed = can_crc(raw[data[:crc_at]], crc)
+        crc_first = int(data[crc_at])
+        delimiter = int(data[crc_at + 14]) + 1
+        if delimiter in stuffed:
+            delimiter += 1
+    if received != computed:
+        return fail(f"CRC error (0x{received:X}, expected 0x{computed:X})", delimiter - 1)
+    annotations.append(Annotation(*span(crc_first, delimiter - 1), f"CRC 0x{received:0{(crc[0] + 3) // 4}X}",
+                                  lane, 'crc', received))
+
+    # CRC delimiter, ACK slot, ACK delimiter and EOF are sent at the nominal rate
+    if brs:
+        if delimiter >= len(raw):
+            return annotations
+        tail_start = begin[delimiter] + sample_point * data_samples + (1 - sample_point) * bit_samples
+        tail, tail_begin = sample_bits(rx, int(round(tail_start)), int(tail_start + 10 * bit_samples),
+                                       bit_samples, sample_point)
+        width[delimiter] = tail_start - begin[delimiter]
+        raw = np.concatenate([raw[:delimiter + 1], tail])
+        begin = np.concatenate([begin[:delimiter + 1], tail_begin])
+        width = np.concatenate([width[:delimiter + 1], np.full(len(tail), bit_samples)])
+    if delimiter + 10 > len(raw):
+        return annotations
+    if raw[delimiter] != 1:
+        return fail("Form error (CRC delimiter)", delimiter)
+    ack = raw[delimiter + 1] == 0
+    annotations.append(Annotation(*span(delimiter + 1, delimiter + 1), 'ACK' if ack else 'No ACK', lane,
+                                  'ack' if ack else 'nack'))
+    if raw[delimiter + 2] != 1:
+        return fail("Form error (ACK delimiter)", delimiter + 2)
+    if not np.all(raw[delimiter + 3:delimiter + 10] == 1):
+        return fail("Form error (EOF)", delimiter + 3 + int(np.argmin(raw[delimiter + 3:delimiter + 10])))
+    annotations.append(Annotation(*span(delimiter + 3, delimiter + 9), 'EOF', lane, 'stop'))
+    return annotations
+
+
+class ParallelDecoder(Decoder):
+    """Parallel bus: D channels grouped into one value, optionally qualified by a clock"""
+
+    name = 'Parallel'
+    parameters = [
+        Parameter('bus', 'Bus name', 'DATA', ['DATA', 'ADDR', 'BUS']),
+        Parameter('bits', 'LSB..MSB', 'D0-D7', ['D0-D3', 'D0-D7', 'D8-D15', 'D0-D15']),
+        Parameter('clock', 'Clock', 'None', channel=True, optional=True),
+        Parameter('edge', 'Clock edge', 'Rising', ['Rising', 'Falling']),
+        Parameter('radix', 'Display', 'Hex', ['Hex', 'Dec']),
+    ]
+
+    def decode(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Decode the bus value segments (or clocked samples) of the listed bits"""
+        sources = parse_sources(settings['bits'])
+        bits = [get_logic_trace(frame, source, threshold) for source in sources]
+        clock = None
+        if settings['clock'] != 'None':
+            clock = get_logic_trace(frame, settings['clock'], threshold)
+        lane = f"{settings['bus'] or 'BUS'}[{len(bits) - 1}:0]"
+        return decode_parallel(bits, clock, settings['edge'] == 'Rising', settings['radix'], lane)
+
+
+def decode_parallel(bits: Sequence[EdgeIndex], clock: Optional[EdgeIndex] = None, rising: bool = True,
+                    radix: str = 'Hex', lane: str = 'BUS') -> List[Annotation]:
+    """
+    Decode a parallel bus
+
+    Without a clock every change of the bus value starts a new segment; with
+    a clock the bits are sampled at each selected clock edge and every sample
+    lasts until the next one.
+
+    Args:
+        bits: Bit traces on one sample grid, bit 0 first
+        clock: Optional qualifying clock (may use another sample grid)
+        rising: Sample on rising (True) or falling clock edges
+        radix: 'Hex' or 'Dec' value labels
+        lane: Lane name of the annotations
+
+    Returns:
+        Value annotations in time order
+    """
+    if radix not in ('Hex', 'Dec'):
+        raise ValueError("Display must be 'Hex' or 'Dec'")
+    if clock is None:
+        points, values = pack_bus(bits)
+        starts = bits[0].times(points)
+        ends = bits[0].times(np.append(points[1:], len(bits[0]) - 1))
+    else:
+        if not bits:
+            raise ValueError("A bus needs at least one bit")
+        samples = clock.rising() if rising else clock.falling()
+        starts = clock.times(samples)
+        ends = np.append(starts[1:], clock.times(len(clock) - 1))
+        values = np.zeros(len(samples), dtype=np.int64)
+        for bit, trace in enumerate(bits):
+            values |= trace.state_at(starts).astype(np.int64) << bit
+    digits = (len(bits) + 3) // 4
+    labels = (f"0x{v:0{digits}X}" for v in values.tolist()) if radix == 'Hex' else map(str, values.tolist())
+    return [Annotation(start, end, text, lane, 'data', value)
+            for start, end, text, value in zip(starts.tolist(), ends.tolist(), labels, values.tolist())]
+
+
+DECODERS: Dict[str, Decoder] = {
+    decoder.name: decoder for decoder in [UartDecoder(), SpiDecoder(), I2cDecoder(), CanDecoder(),
+                                          ParallelDecoder()]
+}
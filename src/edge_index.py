@@ -0,0 +1,229 @@
+"""
+Run-length edge index for logic-analyzer channels
+A digital channel is stored as its initial level plus the sample offsets of
+its transitions, so memory scales with the number of edges, not samples
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+from typing import Optional, Tuple, Union
+
+import numpy as np
+
+
+class EdgeIndex:
+    """
+    Uniformly sampled logic trace stored as transitions
+
+    Sample i has the level of the initial sample flipped once per edge at or
+    before i, so state lookups and range queries are binary searches over the
+    edge offsets. Traces converted from analog samples also keep where each
+    crossing happened between its two samples.
+    """
+
+    __slots__ = ('initial', 'edges', 'length', 't0', 'dt', 'offsets')
+
+    def __init__(self, initial: int, edges: np.ndarray, length: int, t0: float = 0.0, dt: float = 1.0,
+                 offsets: Optional[np.ndarray] = None):
+        """
+        Create an edge index
+
+        Args:
+            initial: Level (0/1) of the first sample
+            edges: Increasing indices of the first sample of every new level
+            length: Number of samples in the trace
+            t0: Time of the first sample in seconds
+            dt: Time between samples in seconds
+            offsets: Optional sub-sample crossing position of every edge, in
+                samples relative to the edge index (-1 < offset <= 0)
+        """
+        self.initial = int(initial)
+        self.edges = np.asarray(edges, dtype=np.int32 if length < 2**31 else np.int64)
+        self.length = int(length)
+        self.t0 = float(t0)
+        self.dt = float(dt)
+        self.offsets = None if offsets is None else np.asarray(offsets, dtype=np.float32)
+
+    @classmethod
+    def from_levels(cls, levels: np.ndarray, t0: float = 0.0, dt: float = 1.0) -> 'EdgeIndex':
+        """
+        Build the index from sampled levels in one vectorized pass
+
+        Args:
+            levels: Logic levels (any nonzero value is high) or a boolean array
+            t0: Time of the first sample in seconds
+            dt: Time between samples in seconds
+        """
+        bits = (np.asarray(levels) != 0).view(np.int8)
+        edges = np.flatnonzero(np.diff(bits)) + 1
+        return cls(bits[0] if len(bits) else 0, edges, len(bits), t0, dt)
+
+    @classmethod
+    def from_samples(cls, time_data: np.ndarray, levels: np.ndarray) -> 'EdgeIndex':
+        """Build the index from a (time_array, level_array) pair as read from the scope"""
+        n = len(time_data)
+        dt = float(time_data[-1] - time_data[0]) / (n - 1) if n > 1 else 1.0
+        return cls.from_levels(levels, float(time_data[0]) if n else 0.0, dt)
+
+    @classmethod
+    def from_analog(cls, time_data: np.ndarray, voltage: np.ndarray, falling: float,
+                    rising: float) -> 'EdgeIndex':
+        """
+        Comparator with hysteresis: analog samples to an edge index
+
+        The output goes high when a sample exceeds the rising threshold and low
+        when one drops below the falling threshold. Only the starts of the
+        runs above/below the thresholds can be edges, so the hysteresis state
+        machine runs over those candidates instead of over every sample. The
+        crossing between the two samples around each edge is interpolated.
+
+        Args:
+            time_data: Uniform sample times in seconds (only the first and the
+                last are used, so a (first, last) pair will do)
+            voltage: Analog samples, or raw ADC codes with the thresholds
+                given as codes
+            falling: Threshold for high-to-low transitions in volts
+            rising: Threshold for low-to-high transitions in volts (>= falling)
+        """
+        if rising < falling:
+            raise ValueError("The rising threshold must not be below the falling threshold")
+        voltage = np.asarray(voltage)
+        n = len(voltage)
+        t0 = float(time_data[0]) if n else 0.0
+        dt = float(time_data[-1] - time_data[0]) / (n - 1) if n > 1 else 1.0
+        if n == 0:
+            return cls(0, np.empty(0, dtype=np.int64), 0, t0, dt)
+
+        above = voltage > rising
+        below = voltage < falling
+        if above[0]:
+            initial = 1
+        elif below[0]:
+            initial = 0
+        else:
+            initial = int(voltage[0] > (falling + rising) / 2)
+        rises = np.flatnonzero(above[1:] & ~above[:-1]) + 1
+        falls = np.flatnonzero(below[1:] & ~below[:-1]) + 1
+
+        # Merge the candidates; an edge is a candidate that changes the level
+        candidates = np.concatenate([rises, falls])
+        levels = np.concatenate([np.ones(len(rises), dtype=np.int8), np.zeros(len(falls), dtype=np.int8)])
+        order = np.argsort(candidates, kind='stable')
+        candidates, levels = candidates[order], levels[order]
+        changes = np.diff(np.concatenate([[initial], levels])) != 0
+        edges, levels = candidates[changes], levels[changes]
+
+        before, after = voltage[edges - 1].astype(np.float64), voltage[edges].astype(np.float64)
+        level = np.where(levels == 1, rising, falling)
+        with np.errstate(invalid='ignore', divide='ignore'):
+            fraction = np.clip((level - before) / (after - before), 0.0, 1.0)
+        return cls(initial, edges, n, t0, dt, np.nan_to_num(fraction, nan=1.0) - 1.0)
+
+    def __len__(self) -> int:
+        return self.length
+
+    @property
+    def nbytes(self) -> int:
+        """Memory held by the edge offsets"""
+        return self.edges.nbytes
+
+    @property
+    def duration(self) -> float:
+        """Time from the first to the last sample"""
+        return max(self.length - 1, 0) * self.dt
+
+    def times(self, indices: Union[int, np.ndarray]) -> Union[float, np.ndarray]:
+        """Sample times of sample indices"""
+        return self.t0 + np.asarray(indices) * self.dt
+
+    def edge_times(self) -> np.ndarray:
+        """Times of the edges, at the interpolated crossing when it is known"""
+        if self.offsets is None:
+            return self.times(self.edges)
+        return self.t0 + (self.edges + self.offsets.astype(np.float64)) * self.dt
+
+    def index_at(self, t: Union[float, np.ndarray]) -> Union[int, np.ndarray]:
+        """Index of the sample in effect at time t (clipped to the trace)"""
+        index = np.clip(np.floor((np.asarray(t) - self.t0) / self.dt + 1e-9), 0, max(self.length - 1, 0))
+        return index.astype(np.int64)
+
+    def edge_levels(self) -> np.ndarray:
+        """Level entered at every edge (1 for rising, 0 for falling)"""
+        return ((np.arange(len(self.edges)) & 1) == self.initial).view(np.uint8)
+
+    def state_at_index(self, indices: Union[int, np.ndarray]) -> Union[int, np.ndarray]:
+        """
+        Level at sample indices, O(log edges) per lookup
+
+        Args:
+            indices: Sample index or array of indices (any shape)
+
+        Returns:
+            Level(s) as uint8
+        """
+        flips = np.searchsorted(self.edges, indices, side='right')
+        return ((flips & 1) ^ self.initial).astype(np.uint8)
+
+    def state_at(self, t: Union[float, np.ndarray]) -> Union[int, np.ndarray]:
+        """Level at time(s) t"""
+        return self.state_at_index(self.index_at(t))
+
+    def edges_in(self, start: int, stop: int) -> np.ndarray:
+        """Edges at sample indices start <= index < stop"""
+        first, last = np.searchsorted(self.edges, [start, stop])
+        return self.edges[first:last]
+
+    def rising(self) -> np.ndarray:
+        """Indices of the rising edges"""
+        return self.edges[self.initial::2]
+
+    def falling(self) -> np.ndarray:
+        """Indices of the falling edges"""
+        return self.edges[1 - self.initial::2]
+
+    def inverted(self) -> 'EdgeIndex':
+        """The same trace with the levels swapped (shares the edge array)"""
+        return EdgeIndex(self.initial ^ 1, self.edges, self.length, self.t0, self.dt, self.offsets)
+
+    def to_levels(self, start: int = 0, stop: Optional[int] = None) -> np.ndarray:
+        """
+        Expand samples start..stop-1 back to a uint8 level array
+
+        Args:
+            start: First sample index
+            stop: Sample index after the last one (default: end of trace)
+        """
+        stop = self.length if stop is None else min(stop, self.length)
+        if stop <= start:
+            return np.empty(0, dtype=np.uint8)
+        toggles = np.zeros(stop - start, dtype=np.uint8)
+        toggles[self.edges_in(start + 1, stop) - start] = 1
+        toggles[0] = self.state_at_index(start)
+        return np.bitwise_xor.accumulate(toggles)
+
+    def step_points(self, time_range: Optional[Tuple[float, float]] = None) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Corner points for drawing the trace as a post-step line
+
+        Only the edges inside the range are visited, so drawing a zoomed view
+        costs O(log edges + visible edges).
+
+        Args:
+            time_range: (start, end) time in seconds; defaults to the whole trace
+
+        Returns:
+            Tuple of (times, levels): the start, every edge and the end
+        """
+        if self.length == 0:
+            return np.empty(0), np.empty(0, dtype=np.uint8)
+        first, last = 0, self.length - 1
+        if time_range is not None:
+            first, last = (int(i) for i in self.index_at(np.asarray(time_range, dtype=np.float64)))
+            last = max(last, first)
+        inner = self.edges_in(first + 1, last + 1)
+        indices = np.concatenate([[first], inner, [last]])
+        levels = self.state_at_index(indices)
+        return self.times(indices), levels
+
+    def __repr__(self) -> str:
+        return f"EdgeIndex(initial={self.initial}, edges={len(self.edges)}, length={self.length})"
@@ -0,0 +1,224 @@
+"""
+Waveform frame export
+CSV blocks are formatted as fixed-point text with integer arithmetic on byte
+matrices, so writing is bound by the disk rather than by one Python format
+call per cell
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+import os
+import threading
+from typing import Callable, Dict, List, Optional, Tuple
+
+import numpy as np
+
+from edge_index import EdgeIndex
+
+logger = logging.getLogger(__name__)
+
+SPACE, POINT, MINUS, ZERO = (ord(c) for c in ' .-0')
+
+
+def _count_digits(values: np.ndarray) -> np.ndarray:
+    """Number of decimal digits of non-negative integers (1 for zero)"""
+    digits = np.ones(values.shape, dtype=np.int64)
+    power = 10
+    while True:
+        more = values >= power
+        if not more.any():
+            return digits
+        digits += more
+        power *= 10
+
+
+def format_fixed(values: np.ndarray, decimals: int) -> np.ndarray:
+    """
+    Fixed-point text of a column as a byte matrix
+
+    Digits are peeled off with vectorized divmod; leading zeros, trailing
+    fraction zeros and a bare decimal point are blanked with spaces, which
+    the writer drops when it joins the row matrix.
+
+    Args:
+        values: Finite numbers
+        decimals: Digits after the decimal point
+
+    Returns:
+        (len(values), width) uint8 matrix, right-aligned and space padded
+    """
+    scaled = np.rint(np.asarray(values, dtype=np.float64) * 10.0 ** decimals).astype(np.int64)
+    negative = scaled < 0
+    magnitude = np.abs(scaled)
+    integer_part = magnitude // 10 ** decimals
+    integer_digits = _count_digits(integer_part)
+    int_width = int(integer_digits.max()) if len(scaled) else 1
+    point = 1 if decimals else 0
+    width = 1 + int_width + point + decimals
+    out = np.empty((len(scaled), width), dtype=np.uint8)
+
+    remaining = magnitude
+    for column in range(width - 1, width - 1 - decimals, -1):
+        remaining, digit = np.divmod(remaining, 10)
+        out[:, column] = digit + ZERO
+    if decimals:
+        out[:, width - 1 - decimals] = POINT
+    for column in range(width - 1 - decimals - point, 0, -1):
+        remaining, digit = np.divmod(remaining, 10)
+        out[:, column] = digit + ZERO
+
+    # Blank leading zeros and put the sign in front of the first digit
+    first_digit = width - decimals - point - integer_digits
+    columns = np.arange(width)
+    out[columns < first_digit[:, None]] = SPACE
+    rows = np.flatnonzero(negative)
+    out[rows, first_digit[rows] - 1] = MINUS
+
+    if decimals:
+        # Blank trailing zeros of the fraction, and the point of whole numbers
+        fraction = out[:, width - decimals:]
+        trailing = np.logical_and.accumulate(fraction[:, ::-1] == ZERO, axis=1)[:, ::-1]
+        fraction[trailing] = SPACE
+        out[trailing[:, 0], width - decimals - 1] = SPACE
+    return out
+
+
+def format_general(values: np.ndarray, significant: int = 9) -> np.ndarray:
+    """Byte matrix like format_fixed for columns that may hold NaN or inf (slow path)"""
+    text = [f"{v:.{significant}g}" for v in np.asarray(values, dtype=np.float64).tolist()]
+    width = max((len(t) for t in text), default=1)
+    return np.frombuffer(''.join(t.rjust(width) for t in text).encode('ascii'),
+                         dtype=np.uint8).reshape(len(text), width)
+
+
+def fixed_decimals(values: np.ndarray, resolution: Optional[float] = None, significant: int = 6) -> int:
+    """
+    Decimals needed for a column
+
+    Args:
+        values: Column values
+        resolution: Smallest step that must stay visible (e.g. the sample
+            interval of a time column); otherwise the largest magnitude
+            keeps the given number of significant digits
+        significant: Significant digits of the largest magnitude
+
+    Returns:
+        Decimals, limited so scaled values stay exact in float64
+    """
+    finite = np.abs(values[np.isfinite(values)])
+    largest = float(finite.max()) if len(finite) else 0.0
+    magnitude = int(np.floor(np.log10(largest))) + 1 if largest > 0 else 1
+    if resolution is not None and resolution > 0:
+        decimals = int(np.ceil(-np.log10(resolution))) + 3
+    else:
+        decimals = significant - magnitude
+    return int(np.clip(decimals, 0, max(15 - magnitude, 0)))
+
+
+def frame_columns(frame, labels: Optional[Dict[int, str]] = None) -> Tuple[List[str], np.ndarray, List]:
+    """
+    Columns of a frame on one time axis
+
+    The time axis is that of the first analog channel, or of the first
+    digital channel when there are none. Analog channels on another grid are
+    interpolated; digital channels are expanded from their edge index.
+
+    Args:
+        frame: WaveformFrame to export
+        labels: Column names of digital channels keyed by number (default Dn)
+
+    Returns:
+        Tuple of (column names, time axis, channel sources) where every source
+        is an analog array or an EdgeIndex
+    """
+    labels = labels or {}
+    names, sources = ['Time'], []
+    time_data = None
+    for ch in sorted(frame.analog):
+        t, voltage = frame.analog[ch]
+        if time_data is None:
+            time_data = np.asarray(t)
+        elif len(t) != len(time_data) or not np.array_equal(t, time_data):
+            voltage = np.interp(time_data, t, voltage)
+        names.append(f"CH{ch}")
+        sources.append(np.asarray(voltage))
+    for d in sorted(frame.digital):
+        trace = frame.digital[d]
+        if time_data is None:
+            time_data = trace.times(np.arange(len(trace)))
+        names.append(labels.get(d, f"D{d}"))
+        sources.append(trace)
+    if time_data is None:
+        raise ValueError("The frame holds no channels")
+    return names, time_data, sources
+
+
+def _digital_block(trace: EdgeIndex, time_data: np.ndarray, start: int, stop: int) -> np.ndarray:
+    """Levels of a digital trace for rows start..stop-1 of the export time axis"""
+    same_grid = len(trace) == len(time_data) and np.isclose(trace.t0, time_data[0]) and \
+        (len(time_data) < 2 or np.isclose(trace.dt, (time_data[-1] - time_data[0]) / (len(time_data) - 1)))
+    if same_grid:
+        return trace.to_levels(start, stop)
+    return trace.state_at(time_data[start:stop])
+
+
+def write_csv(filename: str, frame, labels: Optional[Dict[int, str]] = None, chunk_rows: int = 1 << 18,
+              progress: Optional[Callable[[float], None]] = None,
+              cancel: Optional[threading.Event] = None) -> int:
+    """
+    Write a frame to CSV (Time, CH1-CH4, digital channels), a block of rows at a time
+
+    The file is written under a temporary name and renamed when complete, so
+    a cancelled or failed export leaves no partial file behind.
+
+    Args:
+        filename: Output CSV path
+        frame: WaveformFrame to write
+        labels: Column names of digital channels keyed by number (default Dn)
+        chunk_rows: Rows formatted per block
+        progress: Called with the fraction written after every block
+        cancel: Set to abandon the export
+
+    Returns:
+        Number of data rows written (0 when cancelled)
+    """
+    names, time_data, sources = frame_columns(frame, labels)
+    n = len(time_data)
+    resolution = float(time_data[-1] - time_data[0]) / (n - 1) if n > 1 else None
+    decimals = [fixed_decimals(time_data, resolution)] + \
+               [None if isinstance(source, EdgeIndex) else fixed_decimals(source) for source in sources]
+
+    partial = f"{filename}.part"
+    try:
+        with open(partial, 'wb') as f:
+            f.write((','.join(names) + '\n').encode('utf-8'))
+            for start in range(0, n, chunk_rows):
+                if cancel is not None and cancel.is_set():
+                    break
+                stop = min(start + chunk_rows, n)
+                blocks = []
+                for source, places in zip([time_data] + sources, decimals):
+                    if isinstance(source, EdgeIndex):
+                        block = (_digital_block(source, time_data, start, stop) + ZERO)[:, None]
+                    else:
+                        values = source[start:stop]
+                        finite = np.isfinite(values).all()
+                        block = format_fixed(values, places) if finite else format_general(values)
+                    blocks.append(block)
+                    blocks.append(np.full((stop - start, 1), ord(','), dtype=np.uint8))
+                blocks[-1] = np.full((stop - start, 1), ord('\n'), dtype=np.uint8)
+                rows = np.hstack(blocks)
+                f.write(rows[rows != SPACE].tobytes())
+                if progress is not None:
+                    progress(stop / n)
+        if cancel is not None and cancel.is_set():
+            os.remove(partial)
+            logger.info(f"CSV export to {filename} cancelled")
+            return 0
+        os.replace(partial, filename)
+    except BaseException:
+        if os.path.exists(partial):
+            os.remove(partial)
+        raise
+    return n
@@ -0,0 +1,264 @@
+"""
+HDF5 export of frames and recordings for analysis tools
+Every channel is a chunked, compressed dataset of raw codes (analog) or
+packed bits (digital) with one row per frame, appended one frame at a time
+
+Layout:
+    /                   attrs: format, settings (JSON)
+    /timestamp          (frames,) float64 acquisition times
+    /sequence           (frames,) int64 frame sequence numbers
+    /CHn/codes          (frames, points) uint8/uint16 ADC codes
+    /CHn/preamble       (frames,) x_origin, x_increment, y_increment,
+                        y_origin, y_reference of every frame
+    /CHn                attrs: preamble of the first frame and the conversion
+    /Dn                 (frames, ceil(points / 8)) np.packbits levels;
+                        attrs: length, t0, dt
+
+Usage:
+    python hdf5_export.py soak.h5 soak_*.rcap        # convert a recording
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import argparse
+import json
+import logging
+import os
+import sys
+from typing import Any, Dict, Iterable, Optional
+
+import numpy as np
+
+from acquisition import RawChannel, WaveformFrame
+from capture import quantize, read_records
+
+logger = logging.getLogger(__name__)
+
+PREAMBLE = np.dtype([('x_origin', '<f8'), ('x_increment', '<f8'), ('y_increment', '<f8'),
+                     ('y_origin', '<f8'), ('y_reference', '<f8')])
+COMPRESSIONS = ['gzip', 'lz4', 'none']
+CHUNK_BYTES = 1 << 20
+
+
+def compression_options(name: str) -> Dict[str, Any]:
+    """
+    h5py dataset filter options for a compression name
+
+    'gzip' is deflate level 1 behind the byte shuffle filter; 'lz4' needs the
+    hdf5plugin package and falls back to gzip without it.
+    """
+    if name == 'none':
+        return {}
+    if name == 'lz4':
+        try:
+            import hdf5plugin
+            return dict(hdf5plugin.LZ4())
+        except ImportError:
+            logger.warning("hdf5plugin is not installed; using gzip instead of LZ4")
+    elif name != 'gzip':
+        raise ValueError(f"Compression must be one of {', '.join(COMPRESSIONS)}")
+    return {'compression': 'gzip', 'compression_opts': 1, 'shuffle': True}
+
+
+class HDF5Writer:
+    """
+    Appends frames to an HDF5 file
+
+    The datasets are created from the first frame and grow by one row per
+    frame, so only the frame being written is held in memory. Later frames
+    with other channels or record lengths (e.g. after a channel failed to
+    read) are logged and skipped. The file is written under a temporary name
+    and renamed by close(), so an interrupted export leaves no partial file
+    and does not replace an earlier one.
+    """
+
+    def __init__(self, filename: str, compression: str = 'gzip', settings: Optional[Dict[str, Any]] = None):
+        """
+        Create the file
+
+        Args:
+            filename: Output .h5 path (overwritten)
+            compression: One of COMPRESSIONS
+            settings: Instrument settings stored as a root attribute
+        """
+        import h5py
+        self.filter = compression_options(compression)
+        self.filename = filename
+        self.partial = f"{filename}.part"
+        self.file = h5py.File(self.partial, 'w')
+        self.file.attrs['format'] = 'RIGOL DHO954 frames'
+        self.file.attrs['settings'] = json.dumps(settings or {})
+        self.frames = 0
+        self.skipped = 0
+        self._layout: Optional[Dict[str, int]] = None
+
+    def _dataset(self, name: str, dtype, width: Optional[int] = None):
+        """Extendable dataset with one row (of width items) per frame"""
+        shape = (0,) if width is None else (0, width)
+        if width is None:
+            chunks = (max(CHUNK_BYTES // np.dtype(dtype).itemsize, 1),)
+        else:
+            chunks = (1, max(min(width, CHUNK_BYTES // np.dtype(dtype).itemsize), 1))
+        return self.file.create_dataset(name, shape=shape, maxshape=(None,) + shape[1:], dtype=dtype,
+                                        chunks=chunks, **self.filter)
+
+    def _columns(self, frame: WaveformFrame) -> Dict[str, Any]:
+        """Raw data of every channel of a frame keyed by dataset group name"""
+        columns = {}
+        for ch in sorted(frame.analog):
+            raw = frame.raw.get(ch)
+            columns[f"CH{ch}"] = raw if raw is not None else quantize(*frame.analog[ch])
+        for d in sorted(frame.digital):
+            columns[f"D{d}"] = frame.digital[d]
+        return columns
+
+    def _create(self, columns: Dict[str, Any]) -> None:
+        """Create the datasets for the channels of the first frame"""
+        self._dataset('timestamp', np.float64)
+        self._dataset('sequence', np.int64)
+        self._layout = {}
+        for name, column in columns.items():
+            if isinstance(column, RawChannel):
+                group = self.file.create_group(name)
+                self._dataset(f"{name}/codes", column.codes.dtype, len(column.codes))
+                self._dataset(f"{name}/preamble", PREAMBLE)
+                for field in PREAMBLE.names:
+                    group.attrs[field] = getattr(column, field)
+                group.attrs['units'] = 'V'
+                group.attrs['conversion'] = 'volts = (codes - y_reference - y_origin) * y_increment'
+                self._layout[name] = len(column.codes)
+            else:
+                dataset = self._dataset(name, np.uint8, (len(column) + 7) // 8)
+                dataset.attrs['length'] = len(column)
+                dataset.attrs['t0'] = column.t0
+                dataset.attrs['dt'] = column.dt
+                dataset.attrs['encoding'] = 'np.packbits, first sample in the most significant bit'
+                self._layout[name] = len(column)
+
+    def append(self, frame: WaveformFrame) -> bool:
+        """
+        Write one frame
+
+        Returns:
+            True if written, False if skipped because its channels or record
+            lengths differ from the first frame
+        """
+        columns = self._columns(frame)
+        if self._layout is None:
+            self._create(columns)
+        layout = {name: len(column.codes) if isinstance(column, RawChannel) else len(column)
+                  for name, column in columns.items()}
+        if layout != self._layout:
+            self.skipped += 1
+            logger.warning(f"Skipping frame {frame.sequence}: channels {sorted(layout)} do not match "
+                           f"the file's {sorted(self._layout)} or their lengths differ")
+            return False
+
+        row = self.frames
+        for name in ('timestamp', 'sequence'):
+            self.file[name].resize((row + 1,))
+        self.file['timestamp'][row] = frame.timestamp
+        self.file['sequence'][row] = frame.sequence
+        for name, column in columns.items():
+            if isinstance(column, RawChannel):
+                codes, preamble = self.file[f"{name}/codes"], self.file[f"{name}/preamble"]
+                codes.resize((row + 1, codes.shape[1]))
+                codes[row] = column.codes
+                preamble.resize((row + 1,))
+                preamble[row] = tuple(getattr(column, field) for field in PREAMBLE.names)
+            else:
+                dataset = self.file[name]
+                dataset.resize((row + 1, dataset.shape[1]))
+                dataset[row] = np.packbits(column.to_levels())
+        self.frames += 1
+        return True
+
+    def close(self) -> None:
+        """Flush and close the file and give it its final name"""
+        if self.file is not None:
+            self.file.close()
+            self.file = None
+            os.replace(self.partial, self.filename)
+            if self.skipped:
+                logger.warning(f"{self.filename}: {self.skipped} frames skipped")
+
+    def abort(self) -> None:
+        """Close and delete the partial file"""
+        if self.file is not None:
+            self.file.close()
+            self.file = None
+            os.remove(self.partial)
+
+    def __enter__(self) -> 'HDF5Writer':
+        return self
+
+    def __exit__(self, exc_type, *exc) -> None:
+        if exc_type is None:
+            self.close()
+        else:
+            self.abort()
+
+
+def write_hdf5(filename: str, frames: Iterable[WaveformFrame], compression: str = 'gzip',
+               settings: Optional[Dict[str, Any]] = None) -> int:
+    """
+    Write a frame, or a stream of frames, to an HDF5 file
+
+    Args:
+        filename: Output .h5 path
+        frames: Frames to write (a list or any iterable, consumed one at a time)
+        compression: One of COMPRESSIONS
+        settings: Instrument settings stored as a root attribute
+
+    Returns:
+        Number of frames written
+    """
+    with HDF5Writer(filename, compression, settings) as writer:
+        for frame in frames:
+            writer.append(frame)
+        return writer.frames
+
+
+def convert_recording(filename: str, capture_files: Iterable[str], compression: str = 'gzip') -> int:
+    """
+    Convert capture files (e.g. of a CaptureRecorder run) to one HDF5 file
+
+    Frames are copied record by record from the memory-mapped capture files;
+    the settings of the first record are kept. Frames that do not match the
+    first one are skipped (see HDF5Writer).
+
+    Returns:
+        Number of frames written
+    """
+    writer = None
+    try:
+        for record in read_records(capture_files):
+            if writer is None:
+                writer = HDF5Writer(filename, compression, record.settings)
+            writer.append(record.frame())
+    except BaseException:
+        if writer is not None:
+            writer.abort()
+        raise
+    if writer is None:
+        return 0
+    writer.close()
+    return writer.frames
+
+
+def main() -> int:
+    """Command line entry point"""
+    parser = argparse.ArgumentParser(description="Convert RIGOL capture files to HDF5")
+    parser.add_argument('output', help="Output .h5 file")
+    parser.add_argument('captures', nargs='+', help="Capture (.rcap) files, in recording order")
+    parser.add_argument('--compression', choices=COMPRESSIONS, default='gzip')
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(name)s - %(levelname)s - %(message)s')
+    frames = convert_recording(args.output, sorted(args.captures), args.compression)
+    logger.info(f"Wrote {frames} frames to {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
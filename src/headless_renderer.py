@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+Headless offscreen waveform rendering for RIGOL DHO954 captures
+Renders frames with the GUI's waveform styling on an Agg canvas and writes
+PNG frame sequences, without importing Tk or needing a display
+
+Usage:
+    python headless_renderer.py --output frames/ --fps 2 --count 20          # live
+    python headless_renderer.py --output frames/ --fps 1 --csv run_*.csv     # recorded
+    python headless_renderer.py --output frames/ --capture run_*.rcap        # capture files
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import argparse
+import logging
+import sys
+from pathlib import Path
+from typing import Iterable, List, Optional, Tuple
+
+from matplotlib.backends.backend_agg import FigureCanvasAgg
+
+from acquisition import WaveformFrame, live_frames, load_csv_frame
+from capture import read_capture
+from waveform_figure import create_waveform_figure, create_trace_lines, update_trace_lines
+
+logger = logging.getLogger(__name__)
+
+
+class HeadlessRenderer:
+    """Offscreen renderer that reuses one figure and its artists for every frame"""
+
+    def __init__(self, figsize: Tuple[float, float] = (8, 6), dpi: int = 100):
+        """
+        Initialize offscreen renderer
+
+        Args:
+            figsize: Figure size in inches
+            dpi: Output resolution
+        """
+        self.fig, self.ax, self.ax_digital = create_waveform_figure(figsize=figsize, dpi=dpi)
+        self.canvas = FigureCanvasAgg(self.fig)
+        self.waveform_lines, self.digital_lines = create_trace_lines(self.ax, self.ax_digital)
+
+    def render(self, frame: WaveformFrame) -> None:
+        """
+        Load a frame into the figure artists
+
+        Only channels present in the frame are shown; drawing is deferred to
+        the next write so each frame is rasterized exactly once.
+
+        Args:
+            frame: Frame to render
+        """
+        for ch, line in self.waveform_lines.items():
+            line.set_visible(ch in frame.analog)
+        for d, line in self.digital_lines.items():
+            line.set_visible(d in frame.digital)
+        update_trace_lines(frame, self.waveform_lines, self.digital_lines)
+
+        self.ax.relim(visible_only=True)
+        self.ax.autoscale_view()
+        self.ax_digital.set_visible(bool(frame.digital))
+        if frame.digital:
+            self.ax_digital.relim(visible_only=True)
+            self.ax_digital.autoscale_view(scaley=False)  # Keep Y fixed for digital
+
+    def write_png(self, filename: str) -> None:
+        """
+        Rasterize the current figure and write it as PNG
+
+        Args:
+            filename: Output PNG path
+        """
+        self.canvas.print_png(filename)
+
+    def export_sequence(self, frames: Iterable[WaveformFrame], output_dir: str, fps: float,
+                        pattern: str = "frame_{:05d}.png", max_frames: Optional[int] = None) -> List[str]:
+        """
+        Write a PNG frame sequence at a fixed cadence
+
+        The cadence is measured on frame timestamps: the first frame at or
+        after each 1/fps tick is written and the frames in between are skipped,
+        so live streams and recorded streams are handled the same way.
+
+        Args:
+            frames: Live or recorded frame stream
+            output_dir: Directory for the PNG files (created if missing)
+            fps: Output frames per second of stream time
+            pattern: File name pattern, formatted with the output frame index
+            max_frames: Stop after writing this many PNG files
+
+        Returns:
+            List of written file paths
+        """
+        if fps <= 0:
+            raise ValueError("fps must be positive")
+        out = Path(output_dir)
+        out.mkdir(parents=True, exist_ok=True)
+        period = 1.0 / fps
+
+        written = []
+        next_due = None
+        for frame in frames:
+            if next_due is not None and frame.timestamp < next_due:
+                continue
+            next_due = frame.timestamp + period if next_due is None else next_due + period
+            while next_due <= frame.timestamp:
+                next_due += period
+
+            filename = str(out / pattern.format(len(written)))
+            self.render(frame)
+            self.write_png(filename)
+            written.append(filename)
+            logger.debug(f"Rendered frame {frame.sequence} to {filename}")
+
+            if max_frames is not None and len(written) >= max_frames:
+                break
+
+        logger.info(f"Wrote {len(written)} frames to {out}")
+        return written
+
+
+def parse_channel_list(text: str) -> List[int]:
+    """Parse a channel list such as '1,2' or '0-7,12'"""
+    channels = []
+    for part in filter(None, text.split(',')):
+        if '-' in part:
+            start, end = part.split('-')
+            channels.extend(range(int(start), int(end) + 1))
+        else:
+            channels.append(int(part))
+    return channels
+
+
+def main() -> int:
+    """Command line entry point"""
+    parser = argparse.ArgumentParser(description="Render RIGOL waveforms to PNG without a display")
+    parser.add_argument('--output', required=True, help="Output directory for PNG frames")
+    parser.add_argument('--fps', type=float, default=1.0, help="Output frame cadence (frames/s)")
+    parser.add_argument('--count', type=int, default=None, help="Number of PNG frames to write")
+    parser.add_argument('--channels', default='1', help="Analog channels, e.g. '1,2'")
+    parser.add_argument('--digital', default='', help="Digital channels, e.g. '0-7'")
+    parser.add_argument('--points', type=int, default=1000, help="Points per channel")
+    parser.add_argument('--dpi', type=int, default=100, help="Output resolution")
+    parser.add_argument('--csv', nargs='+', help="Render recorded CSV files instead of live data")
+    parser.add_argument('--capture', nargs='+', help="Render capture (.rcap) files instead of live data")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(name)s - %(levelname)s - %(message)s')
+    renderer = HeadlessRenderer(dpi=args.dpi)
+
+    if args.csv:
+        frames = (load_csv_frame(f, i) for i, f in enumerate(sorted(args.csv)))
+        renderer.export_sequence(frames, args.output, args.fps, max_frames=args.count)
+        return 0
+    if args.capture:
+        frames = (read_capture(f, i) for i, f in enumerate(sorted(args.capture)))
+        renderer.export_sequence(frames, args.output, args.fps, max_frames=args.count)
+        return 0
+
+    from rigol_instrument import RigolDHO954
+    scope = RigolDHO954()
+    try:
+        frames = live_frames(scope, parse_channel_list(args.channels), parse_channel_list(args.digital), args.points)
+        renderer.export_sequence(frames, args.output, args.fps, max_frames=args.count)
+    except KeyboardInterrupt:
+        logger.info("Interrupted")
+    finally:
+        scope.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,187 @@
+"""
+Timing measurements of logic-analyzer channels
+Frequency, period, duty cycle, pulse widths and edge count are computed from
+the edge index of every frame, so no per-value :MEAS: query goes to the scope
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+from typing import Dict, Optional
+
+import numpy as np
+
+from decoders import Threshold, get_logic_trace
+from edge_index import EdgeIndex
+
+logger = logging.getLogger(__name__)
+
+# (column name, format_measurement_value type)
+LOGIC_MEASUREMENTS = [
+    ('Freq', 'FREQ'),
+    ('Period', 'PER'),
+    ('Duty', 'DUTY'),
+    ('+Wid min', 'PWID'),
+    ('+Wid max', 'PWID'),
+    ('-Wid min', 'PWID'),
+    ('-Wid max', 'PWID'),
+    ('Edges', 'EDGES'),
+]
+
+STATISTICS_VIEWS = ['Current', 'Mean', 'Min', 'Max', 'Std dev', 'Count']
+
+# Measurable sources in table order
+LOGIC_SOURCES = [f"D{d}" for d in range(16)] + [f"CH{ch}" for ch in range(1, 5)]
+
+
+def measure_logic(trace: EdgeIndex) -> np.ndarray:
+    """
+    Timing measurements of one logic trace
+
+    Period and duty cycle are averaged over the complete cycles between the
+    first and the last rising edge; pulse widths only count pulses with both
+    edges inside the record. Edges converted from analog channels use their
+    interpolated crossing times.
+
+    Args:
+        trace: Logic trace
+
+    Returns:
+        Values in LOGIC_MEASUREMENTS order; NaN where the record holds too
+        few edges
+    """
+    values = np.full(len(LOGIC_MEASUREMENTS), np.nan)
+    edges = trace.edges
+    values[7] = len(edges)
+    if len(edges) < 2:
+        return values
+
+    times = trace.edge_times()
+    widths = np.diff(times)
+    high = trace.edge_levels()[:-1] == 1
+    if high.any():
+        values[3], values[4] = widths[high].min(), widths[high].max()
+    if not high.all():
+        values[5], values[6] = widths[~high].min(), widths[~high].max()
+
+    # Rising edges sit at positions initial, initial + 2, ... of the edge list
+    first = trace.initial
+    cycles = (len(edges) - 1 - first) // 2
+    if cycles > 0:
+        last = first + 2 * cycles
+        span = times[last] - times[first]
+        values[1] = span / cycles
+        values[0] = 1.0 / values[1]
+        values[2] = 100.0 * widths[first:last:2].sum() / span
+    return values
+
+
+class RunningStatistics:
+    """Count, mean, min, max and standard deviation of a value table over frames (Welford)"""
+
+    def __init__(self, shape):
+        """
+        Create empty statistics
+
+        Args:
+            shape: Shape of the value table updated every frame
+        """
+        self.shape = shape
+        self.reset()
+
+    def reset(self) -> None:
+        """Forget all frames"""
+        self.count = np.zeros(self.shape, dtype=np.int64)
+        self.mean = np.zeros(self.shape)
+        self._m2 = np.zeros(self.shape)
+        self.minimum = np.full(self.shape, np.nan)
+        self.maximum = np.full(self.shape, np.nan)
+
+    def update(self, values: np.ndarray, rows: Optional[np.ndarray] = None) -> None:
+        """
+        Add one frame
+
+        Args:
+            values: New values; NaN entries are skipped
+            rows: Row indices of values when only some rows are updated
+        """
+        index = slice(None) if rows is None else rows
+        valid = ~np.isnan(values)
+        count = self.count[index] + valid
+        delta = np.where(valid, values - self.mean[index], 0.0)
+        mean = self.mean[index] + delta / np.maximum(count, 1)
+        self._m2[index] += np.where(valid, delta * (values - mean), 0.0)
+        self.count[index] = count
+        self.mean[index] = mean
+        self.minimum[index] = np.fmin(self.minimum[index], values)
+        self.maximum[index] = np.fmax(self.maximum[index], values)
+
+    @property
+    def std(self) -> np.ndarray:
+        """Sample standard deviation (NaN below two values)"""
+        with np.errstate(invalid='ignore', divide='ignore'):
+            return np.where(self.count > 1, np.sqrt(self._m2 / (self.count - 1)), np.nan)
+
+
+class LogicMeasurements:
+    """Per-channel timing measurements of every frame with running statistics"""
+
+    def __init__(self):
+        """Initialize the measurements (one statistics row per entry of LOGIC_SOURCES)"""
+        self.statistics = RunningStatistics((len(LOGIC_SOURCES), len(LOGIC_MEASUREMENTS)))
+        self.results: Dict[str, np.ndarray] = {}
+        self.frames = 0
+
+    def reset(self) -> None:
+        """Clear the current values and the running statistics"""
+        self.statistics.reset()
+        self.results = {}
+        self.frames = 0
+
+    def process(self, frame, analog_threshold: Optional[Threshold] = None) -> Dict[str, np.ndarray]:
+        """
+        Measure the channels of a frame
+
+        Args:
+            frame: WaveformFrame to measure
+            analog_threshold: Comparator level(s) for also measuring the analog
+                channels (see decoders.get_logic_trace); None measures the
+                digital channels only
+
+        Returns:
+            Values in LOGIC_MEASUREMENTS order keyed by source name
+        """
+        traces = {f"D{d}": frame.digital[d] for d in sorted(frame.digital)}
+        if analog_threshold is not None:
+            traces.update((f"CH{ch}", get_logic_trace(frame, f"CH{ch}", analog_threshold))
+                          for ch in sorted(frame.analog))
+        sources = list(traces)
+        results = {source: measure_logic(trace) for source, trace in traces.items()}
+        if results:
+            rows = np.array([LOGIC_SOURCES.index(source) for source in sources])
+            self.statistics.update(np.array([results[source] for source in sources]), rows)
+            self.frames += 1
+        self.results = results
+        return results
+
+    def view(self, name: str) -> Dict[str, np.ndarray]:
+        """
+        Values of the sources in the last frame for one of STATISTICS_VIEWS
+
+        Args:
+            name: 'Current' for the last frame, otherwise a running statistic
+
+        Returns:
+            Rows in LOGIC_MEASUREMENTS order keyed by source name
+        """
+        if name == 'Current':
+            return dict(self.results)
+        statistics = self.statistics
+        tables = {'Mean': statistics.mean, 'Min': statistics.minimum, 'Max': statistics.maximum,
+                  'Std dev': statistics.std, 'Count': statistics.count}
+        if name not in tables:
+            raise ValueError(f"View must be one of {', '.join(STATISTICS_VIEWS)}")
+        table = tables[name]
+        if name in ('Mean', 'Std dev'):
+            table = np.where(statistics.count > 0, table, np.nan)
+        return {source: table[LOGIC_SOURCES.index(source)].copy() for source in self.results}
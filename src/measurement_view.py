@@ -0,0 +1,131 @@
+"""
+Logic-analyzer timing measurements window for the RIGOL DHO954 GUI
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+import tkinter as tk
+from tkinter import ttk
+from typing import Callable, Dict, Optional
+
+import numpy as np
+
+from logic_measurements import LOGIC_MEASUREMENTS, LOGIC_SOURCES, STATISTICS_VIEWS
+from utils import format_measurement_value
+
+logger = logging.getLogger(__name__)
+
+
+def format_logic_value(value: float, measurement_type: str) -> str:
+    """Format one table cell; NaN (not measurable) shows as ---"""
+    if np.isnan(value):
+        return "---"
+    return format_measurement_value(float(value), measurement_type)
+
+
+class LogicMeasurementTable:
+    """Toplevel window with one row per measured channel and one column per measurement"""
+
+    def __init__(self, master, on_refresh: Optional[Callable] = None, on_reset: Optional[Callable] = None):
+        """
+        Create the (hidden until shown) measurement window
+
+        Args:
+            master: Parent Tk widget
+            on_refresh: Called when the shown values must be updated (view change)
+            on_reset: Called when the statistics reset button is pressed
+        """
+        self.master = master
+        self.on_refresh = on_refresh
+        self.on_reset = on_reset
+        self.window = None
+        self.tree = None
+        self.view_var = None
+
+    def is_open(self) -> bool:
+        """True while the window exists"""
+        return self.window is not None and self.window.winfo_exists()
+
+    def show(self) -> None:
+        """Create the window, or raise it if it is already open"""
+        if self.is_open():
+            self.window.lift()
+            return
+
+        self.window = tk.Toplevel(self.master)
+        self.window.title("Digital Timing")
+        self.window.geometry("760x360")
+
+        top = ttk.Frame(self.window)
+        top.pack(fill=tk.X, padx=3, pady=2)
+        ttk.Label(top, text="Show:").pack(side=tk.LEFT)
+        self.view_var = tk.StringVar(value='Current')
+        view_combo = ttk.Combobox(top, textvariable=self.view_var, width=8, values=STATISTICS_VIEWS,
+                                  state='readonly')
+        view_combo.pack(side=tk.LEFT, padx=3)
+        view_combo.bind('<<ComboboxSelected>>', lambda e: self._refresh())
+        ttk.Button(top, text="Reset Statistics", command=self._reset).pack(side=tk.RIGHT)
+
+        columns = tuple(name for name, _ in LOGIC_MEASUREMENTS)
+        frame = ttk.Frame(self.window)
+        frame.pack(fill=tk.BOTH, expand=True)
+        self.tree = ttk.Treeview(frame, columns=columns, show='tree headings')
+        self.tree.heading('#0', text='Channel')
+        self.tree.column('#0', width=80, anchor=tk.W)
+        for column in columns:
+            self.tree.heading(column, text=column)
+            self.tree.column(column, width=82, anchor=tk.E)
+        scrollbar = ttk.Scrollbar(frame, orient="vertical", command=self.tree.yview)
+        self.tree.configure(yscrollcommand=scrollbar.set)
+        self.tree.pack(side=tk.LEFT, fill=tk.BOTH, expand=True)
+        scrollbar.pack(side=tk.RIGHT, fill=tk.Y)
+
+        self.status_var = tk.StringVar(value="")
+        ttk.Label(self.window, textvariable=self.status_var).pack(anchor=tk.W, padx=3, pady=2)
+        self._refresh()
+
+    @property
+    def view(self) -> str:
+        """Selected entry of STATISTICS_VIEWS"""
+        return self.view_var.get() if self.is_open() else 'Current'
+
+    def set_values(self, rows: Dict[str, np.ndarray], frames: int,
+                   labels: Optional[Dict[str, str]] = None) -> None:
+        """
+        Show one row per channel
+
+        Args:
+            rows: Values in LOGIC_MEASUREMENTS order keyed by source name
+            frames: Number of frames in the running statistics
+            labels: Display labels keyed by source name
+        """
+        if not self.is_open():
+            return
+        labels = labels or {}
+        counts = self.view == 'Count'
+        stale = set(self.tree.get_children())
+        for position, source in enumerate(sorted(rows, key=LOGIC_SOURCES.index)):
+            if counts:
+                cells = tuple(str(int(n)) for n in rows[source])
+            else:
+                cells = tuple(format_logic_value(v, kind) for v, (_, kind) in zip(rows[source], LOGIC_MEASUREMENTS))
+            if source in stale:
+                self.tree.item(source, text=labels.get(source, source), values=cells)
+                self.tree.move(source, '', position)
+                stale.discard(source)
+            else:
+                self.tree.insert('', position, iid=source, text=labels.get(source, source), values=cells)
+        if stale:
+            self.tree.delete(*stale)
+        self.status_var.set(f"{frames} frames measured")
+
+    def _refresh(self) -> None:
+        """Ask the owner for the values of the selected view"""
+        if self.on_refresh is not None:
+            self.on_refresh()
+
+    def _reset(self) -> None:
+        """Reset the running statistics"""
+        if self.on_reset is not None:
+            self.on_reset()
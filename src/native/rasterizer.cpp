@@ -0,0 +1,192 @@
+/*
+ * Column-span waveform rasterizer for the RIGOL DHO954 live view
+ *
+ * Draws a polyline (or step trace) into an 8-bit RGB image by computing,
+ * for every pixel column the trace crosses, the vertical span covered by the
+ * samples in that column plus the trace value at both column boundaries, and
+ * filling that span. Cost is O(samples + columns + filled pixels).
+ *
+ * Built as the _rasterizer extension module (see setup.py); raster_view.py
+ * falls back to an equivalent numpy implementation when it is not available.
+ *
+ * Author: Sandesh Ghimire <sandesh@soccentric.com>
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* RAII wrapper so every early return releases its Py_buffer */
+struct Buffer {
+    Py_buffer view{};
+    bool acquired = false;
+
+    ~Buffer() {
+        if (acquired) {
+            PyBuffer_Release(&view);
+        }
+    }
+
+    bool get(PyObject *obj, int flags) {
+        acquired = PyObject_GetBuffer(obj, &view, flags) == 0;
+        return acquired;
+    }
+};
+
+/* Trace value at pixel column boundary e; j tracks the segment containing e */
+double value_at(const double *x, const double *y, Py_ssize_t n, double e, Py_ssize_t &j, bool steps) {
+    if (n == 1) {
+        return y[0];
+    }
+    while (j + 1 < n - 1 && x[j + 1] <= e) {
+        ++j;
+    }
+    if (steps) {
+        return (x[j + 1] <= e) ? y[j + 1] : y[j];
+    }
+    const double span = x[j + 1] - x[j];
+    if (!(span > 0.0)) {
+        return y[j];  // Repeated x: no segment to interpolate along
+    }
+    // Same formula as numpy.interp
+    const double slope = (y[j + 1] - y[j]) / span;
+    return slope * (e - x[j]) + y[j];
+}
+
+void draw_spans(uint8_t *image, Py_ssize_t width, const double *x, const double *y, Py_ssize_t n,
+                const uint8_t color[3], Py_ssize_t top, Py_ssize_t bottom, bool steps) {
+    if (n == 0 || bottom <= top) {
+        return;
+    }
+    const double first = std::max(std::floor(x[0]), 0.0);
+    const double last = std::min(std::floor(x[n - 1]), static_cast<double>(width - 1));
+    if (!(first <= last)) {
+        return;  // Off-screen trace or NaN x
+    }
+    const Py_ssize_t c0 = static_cast<Py_ssize_t>(first);
+    const Py_ssize_t c1 = static_cast<Py_ssize_t>(last);
+    const Py_ssize_t columns = c1 - c0 + 1;
+
+    std::vector<double> lo(columns, std::numeric_limits<double>::infinity());
+    std::vector<double> hi(columns, -std::numeric_limits<double>::infinity());
+
+    // Samples inside each column
+    for (Py_ssize_t i = 0; i < n; ++i) {
+        const double c = std::floor(x[i]);
+        if (c < c0 || c > c1) {
+            continue;
+        }
+        const Py_ssize_t k = static_cast<Py_ssize_t>(c) - c0;
+        lo[k] = std::min(lo[k], y[i]);
+        hi[k] = std::max(hi[k], y[i]);
+    }
+
+    // Trace value at each column boundary joins neighbouring columns
+    Py_ssize_t j = 0;
+    for (Py_ssize_t e = c0; e <= c1 + 1; ++e) {
+        const double edge = static_cast<double>(e);
+        if (edge < x[0] || edge > x[n - 1]) {
+            continue;
+        }
+        const double v = value_at(x, y, n, edge, j, steps);
+        if (e <= c1) {
+            lo[e - c0] = std::min(lo[e - c0], v);
+            hi[e - c0] = std::max(hi[e - c0], v);
+        }
+        if (e - 1 >= c0) {
+            lo[e - 1 - c0] = std::min(lo[e - 1 - c0], v);
+            hi[e - 1 - c0] = std::max(hi[e - 1 - c0], v);
+        }
+    }
+
+    // Fill the spans, clipped to the [top, bottom) row band
+    for (Py_ssize_t k = 0; k < columns; ++k) {
+        if (!(lo[k] <= hi[k])) {
+            continue;  // Empty column or NaN samples
+        }
+        // Clamp as doubles first: casting +-inf or out-of-range rows (overrange or
+        // sentinel voltages) to an integer is undefined
+        const double low_row = std::floor(std::clamp(lo[k], top - 1.0, static_cast<double>(bottom)) + 0.5);
+        const double high_row = std::floor(std::clamp(hi[k], top - 1.0, static_cast<double>(bottom)) + 0.5);
+        if (high_row < top || low_row > bottom - 1) {
+            continue;
+        }
+        const Py_ssize_t r0 = std::max(static_cast<Py_ssize_t>(low_row), top);
+        const Py_ssize_t r1 = std::min(static_cast<Py_ssize_t>(high_row), bottom - 1);
+        uint8_t *pixel = image + (r0 * width + c0 + k) * 3;
+        for (Py_ssize_t r = r0; r <= r1; ++r, pixel += width * 3) {
+            pixel[0] = color[0];
+            pixel[1] = color[1];
+            pixel[2] = color[2];
+        }
+    }
+}
+
+PyObject *draw_trace(PyObject *, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"image", "x", "y", "color", "top", "bottom", "steps", nullptr};
+    PyObject *image_obj, *x_obj, *y_obj;
+    int r, g, b;
+    Py_ssize_t top = 0, bottom = -1;
+    int steps = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO(iii)|nnp", const_cast<char **>(keywords),
+                                     &image_obj, &x_obj, &y_obj, &r, &g, &b, &top, &bottom, &steps)) {
+        return nullptr;
+    }
+
+    Buffer image, xs, ys;
+    if (!image.get(image_obj, PyBUF_WRITABLE | PyBUF_ND | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)) {
+        return nullptr;
+    }
+    if (image.view.ndim != 3 || image.view.shape[2] != 3 || image.view.itemsize != 1) {
+        PyErr_SetString(PyExc_ValueError, "image must be a C-contiguous uint8 array of shape (height, width, 3)");
+        return nullptr;
+    }
+    if (!xs.get(x_obj, PyBUF_ND | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) ||
+        !ys.get(y_obj, PyBUF_ND | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)) {
+        return nullptr;
+    }
+    if (xs.view.ndim != 1 || ys.view.ndim != 1 || std::string(xs.view.format) != "d" ||
+        std::string(ys.view.format) != "d" || xs.view.shape[0] != ys.view.shape[0]) {
+        PyErr_SetString(PyExc_ValueError, "x and y must be contiguous float64 arrays of equal length");
+        return nullptr;
+    }
+
+    const Py_ssize_t height = image.view.shape[0];
+    const Py_ssize_t width = image.view.shape[1];
+    if (bottom < 0 || bottom > height) {
+        bottom = height;
+    }
+    top = std::max<Py_ssize_t>(top, 0);
+    const uint8_t color[3] = {static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b)};
+
+    Py_BEGIN_ALLOW_THREADS
+    draw_spans(static_cast<uint8_t *>(image.view.buf), width, static_cast<const double *>(xs.view.buf),
+               static_cast<const double *>(ys.view.buf), xs.view.shape[0], color, top, bottom, steps != 0);
+    Py_END_ALLOW_THREADS
+
+    Py_RETURN_NONE;
+}
+
+PyMethodDef methods[] = {
+    {"draw_trace", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(draw_trace)),
+     METH_VARARGS | METH_KEYWORDS,
+     "draw_trace(image, x, y, color, top=0, bottom=-1, steps=False)\n\n"
+     "Draw a trace into an RGB uint8 image. x and y are float64 pixel coordinates\n"
+     "(x increasing); rows outside [top, bottom) are left untouched."},
+    {nullptr, nullptr, 0, nullptr}};
+
+PyModuleDef module = {PyModuleDef_HEAD_INIT, "_rasterizer", "Column-span waveform rasterizer", -1, methods};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit__rasterizer(void) {
+    return PyModule_Create(&module);
+}
@@ -0,0 +1,132 @@
+"""
+Intensity-graded persistence accumulation for the waveform display
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import time
+from typing import Optional, Tuple
+
+import numpy as np
+from matplotlib import colormaps
+from matplotlib.colors import to_rgb
+
+
+class PersistenceHistogram:
+    """2D time x voltage hit histogram for a single channel"""
+
+    def __init__(self, time_bins: int = 500, voltage_bins: int = 256, decay: Optional[float] = None):
+        """
+        Initialize persistence histogram
+
+        Args:
+            time_bins: Number of horizontal (time) bins
+            voltage_bins: Number of vertical (voltage) bins
+            decay: Decay time in seconds, or None for infinite persistence
+        """
+        self.time_bins = time_bins
+        self.voltage_bins = voltage_bins
+        self.decay = decay
+        self.counts = np.zeros((voltage_bins, time_bins), dtype=np.float32)
+        self.extent: Optional[Tuple[float, float, float, float]] = None
+        self.frames = 0
+        self._last_update: Optional[float] = None
+        self._intensity = np.zeros_like(self.counts)
+        self._rgba = np.zeros((voltage_bins, time_bins, 4), dtype=np.float32)
+
+    def reset(self) -> None:
+        """Clear all accumulated hits"""
+        self.counts.fill(0.0)
+        self.frames = 0
+        self._last_update = None
+
+    def set_decay(self, decay: Optional[float]) -> None:
+        """
+        Set decay time
+
+        Args:
+            decay: Time in seconds after which a hit has faded below 5% of
+                   its initial intensity, or None for infinite persistence
+        """
+        self.decay = decay if decay and decay > 0 else None
+
+    def accumulate(self, time_data: np.ndarray, voltage_data: np.ndarray,
+                   voltage_range: Tuple[float, float], now: Optional[float] = None) -> None:
+        """
+        Add one acquired frame to the histogram
+
+        The grid follows the frame's time span and the given voltage range;
+        accumulated hits are discarded whenever either of them changes.
+
+        Args:
+            time_data: Sample times in seconds
+            voltage_data: Sample voltages in volts
+            voltage_range: (min, max) voltage covered by the vertical bins
+            now: Acquisition timestamp in seconds (defaults to time.monotonic())
+        """
+        if len(time_data) < 2:
+            return
+        now = time.monotonic() if now is None else now
+
+        t0, t1 = float(time_data[0]), float(time_data[-1])
+        v0, v1 = float(voltage_range[0]), float(voltage_range[1])
+        if t1 <= t0 or v1 <= v0:
+            return
+        extent = (t0, t1, v0, v1)
+        if self.extent is None or not np.allclose(extent, self.extent, rtol=1e-6, atol=0.0):
+            self.reset()
+            self.extent = extent
+
+        # Exponential fade, scaled so a hit drops below 5% after `decay` seconds
+        if self.decay is not None and self._last_update is not None:
+            dt = now - self._last_update
+            if dt > 0:
+                self.counts *= np.float32(np.exp(-3.0 * dt / self.decay))
+        self._last_update = now
+
+        ti = ((np.asarray(time_data) - t0) * (self.time_bins / (t1 - t0))).astype(np.intp)
+        np.minimum(ti, self.time_bins - 1, out=ti)
+        vi = np.floor((np.asarray(voltage_data) - v0) * (self.voltage_bins / (v1 - v0))).astype(np.intp)
+        valid = (vi >= 0) & (vi < self.voltage_bins)
+
+        flat = vi[valid] * self.time_bins + ti[valid]
+        hits = np.bincount(flat, minlength=self.counts.size)
+        counts = self.counts.reshape(-1)
+        np.add(counts, hits, out=counts, casting='unsafe')
+        self.frames += 1
+
+    def intensity(self) -> np.ndarray:
+        """
+        Get log-compressed hit intensity normalized to 0..1
+
+        Returns:
+            Array of shape (voltage_bins, time_bins), row 0 is the lowest voltage
+        """
+        peak = float(self.counts.max()) if self.frames else 0.0
+        if peak <= 0.0:
+            self._intensity.fill(0.0)
+            return self._intensity
+        np.log1p(self.counts, out=self._intensity)
+        self._intensity *= np.float32(1.0 / np.log1p(peak))
+        return self._intensity
+
+    def to_rgba(self, color: str, colormap: str = 'channel') -> np.ndarray:
+        """
+        Render the histogram as an RGBA image
+
+        Args:
+            color: Channel trace color, used when colormap is 'channel'
+            colormap: 'channel' to grade intensity in the trace color, or the
+                      name of a matplotlib colormap
+
+        Returns:
+            Float RGBA array of shape (voltage_bins, time_bins, 4); empty bins are transparent
+        """
+        intensity = self.intensity()
+        if colormap == 'channel':
+            self._rgba[..., :3] = to_rgb(color)
+            self._rgba[..., 3] = intensity
+        else:
+            self._rgba[...] = colormaps[colormap](intensity)
+            self._rgba[..., 3] = intensity > 0
+        return self._rgba
@@ -0,0 +1,247 @@
+"""
+Lightweight raster live view for the waveform display
+Rasterizes traces straight into a numpy RGB buffer and shows it through a
+Tk PhotoImage, bypassing matplotlib for high frame-rate live viewing
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+from typing import Dict, Optional, Tuple
+
+import numpy as np
+from matplotlib.colors import to_rgb
+
+from waveform_figure import ANALOG_COLORS, DIGITAL_COLORS
+
+logger = logging.getLogger(__name__)
+
+try:
+    import _rasterizer
+except ImportError:
+    _rasterizer = None
+    logger.debug("Native rasterizer not built, using numpy fallback (run 'make ext')")
+
+BACKGROUND = (0x00, 0x1a, 0x00)
+GRID = (0x00, 0x33, 0x00)
+DIVIDER = (0x00, 0x66, 0x00)
+
+
+def _hex_to_rgb8(color: str) -> Tuple[int, int, int]:
+    """Convert a matplotlib color to an 8-bit RGB tuple"""
+    return tuple(int(round(c * 255)) for c in to_rgb(color))
+
+
+def draw_trace_numpy(image: np.ndarray, x: np.ndarray, y: np.ndarray, color: Tuple[int, int, int],
+                     top: int = 0, bottom: int = -1, steps: bool = False) -> None:
+    """
+    Vectorized column-span trace drawing (fallback for the native rasterizer)
+
+    Every pixel column crossed by the trace is filled between the lowest and
+    highest trace value inside the column, including the (linear or step)
+    trace value at both column boundaries so neighbouring columns join up.
+
+    Args:
+        image: RGB uint8 image of shape (height, width, 3), modified in place
+        x: Sample x positions in pixels, increasing
+        y: Sample y positions in pixels (row 0 at the top)
+        color: 8-bit RGB trace color
+        top: First row the trace may touch
+        bottom: Row after the last one the trace may touch (-1 for image height)
+        steps: Hold each sample until the next one instead of joining linearly
+    """
+    height, width = image.shape[:2]
+    bottom = height if bottom < 0 or bottom > height else bottom
+    top = max(top, 0)
+    n = len(x)
+    if n == 0 or bottom <= top:
+        return
+
+    c0 = int(max(np.floor(x[0]), 0))
+    c1 = int(min(np.floor(x[-1]), width - 1))
+    if c1 < c0:
+        return
+
+    # Sample points and column boundary points, each tagged with its column
+    cols = np.floor(x)
+    inside = (cols >= c0) & (cols <= c1)
+    edges = np.arange(c0, c1 + 2, dtype=np.float64)
+    edges = edges[(edges >= x[0]) & (edges <= x[-1])]
+    if n == 1:
+        edge_values = np.full(len(edges), y[0])
+    elif steps:
+        edge_values = y[np.clip(np.searchsorted(x, edges, side='right') - 1, 0, n - 1)]
+    else:
+        edge_values = np.interp(edges, x, y)
+
+    # A boundary belongs to the column on its right and the one on its left
+    point_cols = np.concatenate([cols[inside], edges, edges - 1]).astype(np.intp) - c0
+    point_vals = np.concatenate([y[inside], edge_values, edge_values])
+    keep = (point_cols >= 0) & (point_cols <= c1 - c0)
+    point_cols, point_vals = point_cols[keep], point_vals[keep]
+
+    columns = c1 - c0 + 1
+    lo = np.full(columns, np.inf)
+    hi = np.full(columns, -np.inf)
+    with np.errstate(invalid='ignore'):  # Segments between infinite rows interpolate to NaN
+        np.minimum.at(lo, point_cols, point_vals)
+        np.maximum.at(hi, point_cols, point_vals)
+
+    filled = lo <= hi
+    r0 = np.floor(lo + 0.5)
+    r1 = np.floor(hi + 0.5)
+    filled &= (r1 >= top) & (r0 <= bottom - 1)
+    r0 = np.clip(r0, top, bottom - 1)
+    r1 = np.clip(r1, top, bottom - 1)
+
+    rows = np.arange(top, bottom)[:, None]
+    mask = filled & (rows >= r0) & (rows <= r1)
+    image[top:bottom, c0:c1 + 1][mask] = color
+
+
+def draw_trace(image: np.ndarray, x: np.ndarray, y: np.ndarray, color: Tuple[int, int, int],
+               top: int = 0, bottom: int = -1, steps: bool = False) -> None:
+    """Draw a trace with the native rasterizer when available (see draw_trace_numpy)"""
+    if _rasterizer is not None:
+        _rasterizer.draw_trace(image, np.ascontiguousarray(x, dtype=np.float64),
+                               np.ascontiguousarray(y, dtype=np.float64), color, top, bottom, steps)
+    else:
+        draw_trace_numpy(image, x, y, color, top, bottom, steps)
+
+
+class RasterCanvas:
+    """Fixed-grid RGB frame buffer with analog traces on top and digital lanes below"""
+
+    def __init__(self, width: int = 800, height: int = 600, digital: bool = True):
+        """
+        Initialize raster canvas
+
+        Args:
+            width: Image width in pixels
+            height: Image height in pixels
+            digital: Reserve the lower part of the image for the 16 digital lanes
+        """
+        self.analog_colors = {ch: _hex_to_rgb8(c) for ch, c in enumerate(ANALOG_COLORS, start=1)}
+        self.digital_colors = {d: _hex_to_rgb8(c) for d, c in enumerate(DIGITAL_COLORS)}
+        self.resize(width, height, digital)
+
+    def resize(self, width: int, height: int, digital: Optional[bool] = None) -> None:
+        """Reallocate buffers for a new image size and redraw the background grid"""
+        self.width = max(int(width), 16)
+        self.height = max(int(height), 16)
+        if digital is not None:
+            self.digital = digital
+        self.analog_bottom = int(self.height * 0.6) if self.digital else self.height
+        self.image = np.empty((self.height, self.width, 3), dtype=np.uint8)
+        self.background = np.empty_like(self.image)
+        self._draw_background()
+
+    def _draw_background(self) -> None:
+        """Render the graticule once; every frame starts from a copy of it"""
+        bg = self.background
+        bg[...] = BACKGROUND
+        for i in range(1, 10):  # 10 horizontal divisions
+            bg[:, i * self.width // 10] = GRID
+        for i in range(1, 8):  # 8 vertical divisions
+            bg[i * self.analog_bottom // 8, :] = GRID
+        if self.digital and self.analog_bottom < self.height:
+            bg[self.analog_bottom, :] = DIVIDER
+
+    def render(self, frame, voltage_ranges: Dict[int, Tuple[float, float]],
+               time_range: Optional[Tuple[float, float]] = None) -> np.ndarray:
+        """
+        Rasterize a frame
+
+        Args:
+            frame: WaveformFrame to draw
+            voltage_ranges: On-screen (min, max) voltage per analog channel
+            time_range: (start, end) time in seconds; defaults to the frame's span
+
+        Returns:
+            RGB uint8 image of shape (height, width, 3)
+        """
+        np.copyto(self.image, self.background)
+        if time_range is None:
+            time_range = self._frame_time_range(frame)
+            if time_range is None:
+                return self.image
+        t0, t1 = time_range
+        x_scale = (self.width - 1) / (t1 - t0) if t1 > t0 else 0.0
+
+        for ch in frame.analog:
+            # Only the samples inside the time range are converted to volts
+            time_data, voltage_data = frame.analog_window(ch, time_range)
+            v0, v1 = voltage_ranges.get(ch, (-4.0, 4.0))
+            x = (np.asarray(time_data, dtype=np.float64) - t0) * x_scale
+            y = (v1 - np.asarray(voltage_data, dtype=np.float64)) * ((self.analog_bottom - 1) / (v1 - v0))
+            draw_trace(self.image, x, y, self.analog_colors[ch], 0, self.analog_bottom)
+
+        if self.digital and frame.digital:
+            lane = (self.height - self.analog_bottom - 1) / 16.0
+            for d, edges in frame.digital.items():
+                # D0 in the bottom lane, matching the matplotlib view; high is up
+                lane_top = self.analog_bottom + 1 + (15 - d) * lane
+                high, low = lane_top + 0.15 * lane, lane_top + 0.85 * lane
+                time_data, levels = edges.step_points(time_range)
+                x = (time_data - t0) * x_scale
+                y = low + (high - low) * levels.astype(np.float64)
+                draw_trace(self.image, x, y, self.digital_colors[d],
+                           int(lane_top), int(lane_top + lane), steps=True)
+
+        return self.image
+
+    @staticmethod
+    def _frame_time_range(frame) -> Optional[Tuple[float, float]]:
+        """Time span of the first channel in the frame"""
+        for ch in frame.analog:
+            if frame.analog.length(ch) > 1:
+                return frame.analog.time_range(ch)
+        for edges in frame.digital.values():
+            if len(edges) > 1:
+                return edges.t0, edges.t0 + edges.duration
+        return None
+
+    def to_ppm(self) -> bytes:
+        """Encode the current image as binary PPM for Tk PhotoImage"""
+        header = f"P6 {self.width} {self.height} 255 ".encode('ascii')
+        return header + self.image.tobytes()
+
+
+class RasterWaveformView:
+    """Tk live-view widget showing a RasterCanvas through a PhotoImage"""
+
+    def __init__(self, master, width: int = 800, height: int = 600):
+        """
+        Initialize the live view widget
+
+        Args:
+            master: Parent Tk widget
+            width: Initial width in pixels
+            height: Initial height in pixels
+        """
+        import tkinter as tk  # Keep the module importable without Tk for RasterCanvas
+
+        self.raster = RasterCanvas(width, height)
+        self.photo = tk.PhotoImage(master=master)
+        self.widget = tk.Label(master, image=self.photo, background='black', borderwidth=0,
+                               highlightthickness=0, padx=0, pady=0)
+        self.widget.bind('<Configure>', self._on_configure)
+
+    def _on_configure(self, event) -> None:
+        """Follow the widget size"""
+        if event.width != self.raster.width or event.height != self.raster.height:
+            self.raster.resize(event.width, event.height)
+
+    def show(self, frame, voltage_ranges: Dict[int, Tuple[float, float]], digital: bool = True) -> None:
+        """
+        Rasterize a frame and display it
+
+        Args:
+            frame: WaveformFrame to display
+            voltage_ranges: On-screen (min, max) voltage per analog channel
+            digital: Show the digital lanes
+        """
+        if digital != self.raster.digital:
+            self.raster.resize(self.raster.width, self.raster.height, digital)
+        self.raster.render(frame, voltage_ranges)
+        self.photo.configure(data=self.raster.to_ppm(), format='PPM')
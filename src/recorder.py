@@ -0,0 +1,153 @@
+"""
+Continuous recording of acquired frames to capture files
+The acquisition pipeline stage only queues frames; a writer thread appends
+them to .rcap files with an index sidecar, rotating files by size or time
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+import os
+import queue
+import threading
+from typing import Any, Dict, List, Optional
+
+import numpy as np
+
+from acquisition import WaveformFrame
+from capture import INDEX, write_record
+
+logger = logging.getLogger(__name__)
+
+
+class CaptureRecorder:
+    """
+    Streams every submitted frame to disk without blocking the submitter
+
+    Frames wait in a bounded queue for the writer thread. When the disk does
+    not keep up the queue fills and further frames are dropped and counted
+    instead of stalling acquisition.
+    """
+
+    def __init__(self, filename: str, max_bytes: Optional[int] = None, max_seconds: Optional[float] = None,
+                 queue_depth: int = 16, settings: Optional[Dict[str, Any]] = None):
+        """
+        Start a recording
+
+        Args:
+            filename: Base path; files are named <base>_0000.rcap, <base>_0001.rcap, ...
+            max_bytes: Start a new file once the current one reaches this size
+            max_seconds: Start a new file once the current one spans this much
+                frame time
+            queue_depth: Frames that may wait for the writer
+            settings: Instrument settings stored with every frame
+        """
+        base, _ = os.path.splitext(filename)
+        self.base = base
+        self.max_bytes = max_bytes
+        self.max_seconds = max_seconds
+        self.settings = settings
+        self.files: List[str] = []
+        self.frames_written = 0
+        self.frames_dropped = 0
+        self.bytes_written = 0
+        self.error: Optional[Exception] = None
+
+        self._queue: queue.Queue = queue.Queue(maxsize=queue_depth)
+        self._lock = threading.Lock()
+        self._file = None
+        self._index = None
+        self._file_start: Optional[float] = None
+        self._closed = False
+        self._thread = threading.Thread(target=self._run, name="CaptureRecorder", daemon=True)
+        self._thread.start()
+
+    def submit(self, frame: WaveformFrame) -> bool:
+        """
+        Acquisition pipeline stage: queue a frame for writing
+
+        Returns:
+            True if the frame was queued, False if it was dropped
+        """
+        if self._closed or self.error is not None:
+            return False
+        try:
+            self._queue.put_nowait(frame)
+            return True
+        except queue.Full:
+            with self._lock:
+                self.frames_dropped += 1
+                dropped = self.frames_dropped
+            if dropped == 1 or dropped % 100 == 0:
+                logger.warning(f"Recorder falling behind: {dropped} frames dropped")
+            return False
+
+    @property
+    def pending(self) -> int:
+        """Frames waiting for the writer"""
+        return self._queue.qsize()
+
+    def _open_next(self, timestamp: float) -> None:
+        """Close the current file and start the next one"""
+        self._close_file()
+        filename = f"{self.base}_{len(self.files):04d}.rcap"
+        self._file = open(filename, 'wb')
+        self._index = open(f"{filename}.idx", 'wb')
+        self._file_start = timestamp
+        self.files.append(filename)
+        logger.info(f"Recording to {filename}")
+
+    def _close_file(self) -> None:
+        if self._file is not None:
+            self._file.close()
+            self._index.close()
+            self._file = self._index = None
+
+    def _rotate_due(self, frame: WaveformFrame) -> bool:
+        """Whether the next frame goes to a new file"""
+        if self._file is None:
+            return True
+        if self.max_bytes is not None and self._file.tell() >= self.max_bytes:
+            return True
+        return self.max_seconds is not None and frame.timestamp - self._file_start >= self.max_seconds
+
+    def _run(self) -> None:
+        """Writer thread: append queued frames until the None sentinel"""
+        while True:
+            frame = self._queue.get()
+            if frame is None:
+                break
+            if self.error is not None:
+                continue
+            try:
+                if self._rotate_due(frame):
+                    self._open_next(frame.timestamp)
+                start, end = write_record(self._file, frame, self.settings)
+                # The data is flushed before its index entry, so the index never points past the file
+                self._file.flush()
+                entry = np.array([(start, frame.timestamp, frame.sequence)], dtype=INDEX)
+                self._index.write(entry.tobytes())
+                self._index.flush()
+                with self._lock:
+                    self.frames_written += 1
+                    self.bytes_written += end - start
+            except Exception as e:
+                self.error = e
+                logger.error(f"Recording stopped: {e}")
+        self._close_file()
+
+    def status(self) -> Dict[str, Any]:
+        """Counters for display: frames written/dropped, bytes, files, pending frames and error"""
+        with self._lock:
+            return {'written': self.frames_written, 'dropped': self.frames_dropped, 'bytes': self.bytes_written,
+                    'files': len(self.files), 'pending': self.pending, 'error': self.error}
+
+    def close(self) -> None:
+        """Write the queued frames and close the files"""
+        if self._closed:
+            return
+        self._closed = True
+        self._queue.put(None)
+        self._thread.join()
+        logger.info(f"Recording closed: {self.frames_written} frames in {len(self.files)} files, "
+                    f"{self.bytes_written / 1e6:.1f} MB, {self.frames_dropped} dropped")
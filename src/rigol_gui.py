@@ -5,6 +5,8 @@ Main GUI application module
 Author: Sandesh Ghimire <sandesh@soccentric.com>
 """
 
+import itertools
+import os
 import time
 import numpy as np
 import matplotlib.pyplot as plt
@@ -14,13 +16,32 @@ import tkinter as tk
 from tkinter import ttk, messagebox, filedialog
 import threading
 import logging
+from typing import Optional
 
 from rigol_instrument import RigolDHO954
 from config import Config
+from acquisition import AcquisitionPipeline, acquire_frame, prefetch
+from decoders import DECODERS, frame_duration
+from decoder_view import DecoderTable
+from capture import CaptureFile, read_records, write_capture
+from export import write_csv
+from hdf5_export import write_hdf5
+from search import SEARCHES, search_frames
+from logic_measurements import LOGIC_SOURCES, LogicMeasurements
+from measurement_view import LogicMeasurementTable
+from persistence import PersistenceHistogram
+from raster_view import RasterWaveformView
+from spectrum import (AVERAGING_MODES, SpectrogramBuffer, SpectrumAnalyzer, SpectrumAverager,
+                      StreamingWelch, ToneMonitor, WINDOW_COEFFICIENTS)
+from recorder import CaptureRecorder
+from trend import TrendLogger
+from waveform_figure import (ANALOG_COLORS, create_waveform_figure, create_trace_lines, update_trace_lines,
+                             create_spectrum_axes, create_spectrum_lines, create_waterfall_axes,
+                             set_spectrum_visible, style_axes, draw_annotations)
 from utils import (setup_logging, format_measurement_value, validate_channel_number, 
                    validate_scale_value, validate_offset_value, validate_trigger_level,
                    validate_digital_channel, validate_digital_threshold, validate_digital_label,
-                   is_valid_threshold_type)
+                   is_valid_threshold_type, parse_logic_threshold)
 
 logger = logging.getLogger(__name__)
 
@@ -41,6 +62,7 @@ class OscilloscopeGUI:
         self.scope: Optional[RigolDHO954] = None
         self.is_running = False
         self.update_thread: Optional[threading.Thread] = None
+        self.scope_busy = False  # A background transfer (deep record) owns the VISA session
 
         # Load configuration values
         self.window_size = self.config.get('gui.window_size', '1920x1080')
@@ -50,7 +72,23 @@ class OscilloscopeGUI:
         # Track collapsible section states
         self.sections_collapsed = {}
 
+        # Acquisition feeds every frame to the analysis stages; the display
+        # renders only the newest frame on its own fixed-cadence tick
+        self.pipeline = AcquisitionPipeline()
+        self.display_interval_ms = max(1, int(1000 / self.config.get('display.fps', 30)))
+        self.redraw_pending = False
+        self.displayed_frame = None  # Frame currently on screen; what Save Data exports
+        self.persistence_lock = threading.Lock()
+
+        # Rendering pauses while the window is minimized, the plot is fully
+        # covered or the display section is collapsed
+        self.window_mapped = True
+        self.canvas_mapped = True
+        self.canvas_obscured = False
+        self.render_suspended = False
+
         self.setup_ui()
+        self.root.after(self.display_interval_ms, self.display_tick)
 
         logger.info("Oscilloscope GUI initialized")
 
@@ -98,6 +136,9 @@ class OscilloscopeGUI:
 
         ttk.Button(toolbar, text="📷 Screenshot", command=self.take_screenshot).pack(side=tk.LEFT, padx=2)
         ttk.Button(toolbar, text="💾 Save Data", command=self.save_waveform).pack(side=tk.LEFT, padx=2)
+        self.record_var = tk.BooleanVar(value=False)
+        ttk.Checkbutton(toolbar, text="⏺ Record", variable=self.record_var,
+                        command=self.toggle_recording).pack(side=tk.LEFT, padx=2)
         ttk.Button(toolbar, text="📊 FFT", command=self.toggle_fft_display, style="Blue.TButton").pack(side=tk.LEFT, padx=2)
         ttk.Button(toolbar, text="📐 Math", command=self.show_math_functions).pack(side=tk.LEFT, padx=2)
         
@@ -109,6 +150,14 @@ class OscilloscopeGUI:
         # Statistics display
         self.acq_rate_label = ttk.Label(toolbar, text="Acq: 0 wfm/s", relief=tk.SUNKEN, width=12)
         self.acq_rate_label.pack(side=tk.RIGHT, padx=2)
+        self.export_label = ttk.Label(toolbar, text="")
+        self.export_label.pack(side=tk.RIGHT, padx=2)
+        self.export_thread: Optional[threading.Thread] = None
+        self.export_cancel = threading.Event()
+        self.record_label = ttk.Label(toolbar, text="")
+        self.record_label.pack(side=tk.RIGHT, padx=2)
+        self.recorder: Optional[CaptureRecorder] = None
+        self.closing_recorders = []  # (recorder, helper thread) pairs still writing their queues
         
         self.status_label = ttk.Label(toolbar, text="● Not Connected", foreground="red", font=('Arial', 9, 'bold'))
         self.status_label.pack(side=tk.RIGHT, padx=10)
@@ -158,6 +207,9 @@ class OscilloscopeGUI:
         self.setup_timebase_controls(left_panel)
         self.setup_trigger_controls(left_panel)
         self.setup_acquisition_controls(left_panel)
+        self.setup_display_controls(left_panel)
+        self.setup_spectrum_controls(left_panel)
+        self.setup_tone_controls(left_panel)
 
         # Setup middle panel - Waveform display and measurements
         self.setup_waveform_display(middle_panel)
@@ -165,6 +217,8 @@ class OscilloscopeGUI:
 
         # Setup right panel - Digital controls
         self.setup_logic_analyzer_controls(right_panel)
+        self.setup_decoder_controls(right_panel)
+        self.setup_search_controls(right_panel)
 
     def setup_channel_controls(self, parent: ttk.Frame) -> None:
         """Setup channel control section"""
@@ -336,6 +390,109 @@ class OscilloscopeGUI:
         ttk.Button(bulk_frame, text="D0-D7", command=lambda: self.enable_digital_group(0, 7)).pack(side=tk.LEFT, padx=2)
         ttk.Button(bulk_frame, text="D8-D15", command=lambda: self.enable_digital_group(8, 15)).pack(side=tk.LEFT, padx=2)
 
+        # Timing measurements of every frame, computed from the edge index
+        timing_frame = ttk.Frame(frame)
+        timing_frame.pack(fill=tk.X, pady=3)
+        self.logic_measure_var = tk.BooleanVar(value=False)
+        ttk.Checkbutton(timing_frame, text="Measure Timing", variable=self.logic_measure_var,
+                        command=self.toggle_logic_measurements).pack(side=tk.LEFT, padx=2)
+        ttk.Button(timing_frame, text="Timing Table", command=self.show_logic_measurements).pack(side=tk.LEFT, padx=2)
+        self.logic_measure_analog_var = tk.BooleanVar(value=False)
+        ttk.Checkbutton(timing_frame, text="+CH1-4", variable=self.logic_measure_analog_var,
+                        command=self.toggle_logic_measurements).pack(side=tk.LEFT, padx=2)
+
+        self.logic_measure_enabled = False
+        self.logic_measure_threshold = None  # Comparator levels for analog channels, if measured
+        self.logic_measurements = LogicMeasurements()
+        self.logic_lock = threading.Lock()
+        self.logic_table = LogicMeasurementTable(self.root, on_refresh=self.update_logic_measurement_display,
+                                                 on_reset=self.reset_logic_measurements)
+        self.pipeline.add_stage(self.measure_logic_frame)
+
+    def setup_decoder_controls(self, parent: ttk.Frame) -> None:
+        """Setup protocol decoder control section"""
+        frame = ttk.LabelFrame(parent, text="Protocol Decoder", padding=5)
+        frame.pack(fill=tk.X, pady=3)
+
+        # Protocol
+        protocol_frame = ttk.Frame(frame)
+        protocol_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(protocol_frame, text="Protocol:").pack(side=tk.LEFT, padx=2)
+        self.decoder_protocol_var = tk.StringVar(value=self.config.get('decoder.protocol', 'UART'))
+        protocol_combo = ttk.Combobox(protocol_frame, textvariable=self.decoder_protocol_var, width=8,
+                                      values=list(DECODERS), state='readonly')
+        protocol_combo.pack(side=tk.LEFT, padx=5)
+        protocol_combo.bind('<<ComboboxSelected>>', lambda e: self.build_decoder_parameters())
+
+        # Per-protocol settings, rebuilt when the protocol changes
+        self.decoder_params_frame = ttk.Frame(frame)
+        self.decoder_params_frame.pack(fill=tk.X, pady=2)
+        self.decoder_param_vars = {}
+
+        # Comparator for analog (CHn) sources: threshold family or level, and hysteresis
+        threshold_frame = ttk.Frame(frame)
+        threshold_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(threshold_frame, text="Analog thr:").pack(side=tk.LEFT, padx=2)
+        self.decoder_threshold_var = tk.StringVar(value=str(self.config.get('decoder.analog_threshold', 1.4)))
+        threshold_combo = ttk.Combobox(threshold_frame, textvariable=self.decoder_threshold_var, width=7,
+                                       values=['TTL', 'CMOS5', 'CMOS3', 'ECL', 'LVTTL', 'LVCMOS3', 'LVCMOS2'])
+        threshold_combo.pack(side=tk.LEFT, padx=2)
+        ttk.Label(threshold_frame, text="Hyst (V):").pack(side=tk.LEFT, padx=2)
+        self.decoder_hysteresis_var = tk.StringVar(value=str(self.config.get('decoder.hysteresis', 0.1)))
+        ttk.Entry(threshold_frame, textvariable=self.decoder_hysteresis_var, width=5).pack(side=tk.LEFT, padx=2)
+
+        button_frame = ttk.Frame(frame)
+        button_frame.pack(fill=tk.X, pady=3)
+        ttk.Button(button_frame, text="Decode", command=self.decode_protocol).pack(side=tk.LEFT, padx=2)
+        ttk.Button(button_frame, text="Table", command=self.show_decoder_table).pack(side=tk.LEFT, padx=2)
+        ttk.Button(button_frame, text="Clear", command=self.clear_decoder).pack(side=tk.LEFT, padx=2)
+
+        self.decoder_live_var = tk.BooleanVar(value=False)
+        ttk.Checkbutton(frame, text="Decode every frame", variable=self.decoder_live_var,
+                        command=self.toggle_live_decode).pack(anchor=tk.W, pady=1)
+
+        self.decoder_table = DecoderTable(self.root, on_select=self.show_decoder_cursor)
+        self.decoder_annotations = []
+        self.decoder_statistics = {}
+        self.decoder_artists = []
+        self.decoder_cursor = []
+        self.decoder_settings = None  # Snapshot used by the acquisition thread
+        self.decoder_lock = threading.Lock()
+        self.decoder_updated = False
+        self.build_decoder_parameters()
+        self.pipeline.add_stage(self.decode_frame)
+
+    def setup_search_controls(self, parent: ttk.Frame) -> None:
+        """Setup post-capture search section"""
+        frame = ttk.LabelFrame(parent, text="Search", padding=5)
+        frame.pack(fill=tk.X, pady=3)
+
+        type_frame = ttk.Frame(frame)
+        type_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(type_frame, text="Find:").pack(side=tk.LEFT, padx=2)
+        self.search_type_var = tk.StringVar(value=self.config.get('search.type', 'Glitch'))
+        type_combo = ttk.Combobox(type_frame, textvariable=self.search_type_var, width=10,
+                                  values=list(SEARCHES), state='readonly')
+        type_combo.pack(side=tk.LEFT, padx=5)
+        type_combo.bind('<<ComboboxSelected>>', lambda e: self.build_search_parameters())
+
+        # Per-search settings, rebuilt when the search type changes
+        self.search_params_frame = ttk.Frame(frame)
+        self.search_params_frame.pack(fill=tk.X, pady=2)
+        self.search_param_vars = {}
+
+        button_frame = ttk.Frame(frame)
+        button_frame.pack(fill=tk.X, pady=3)
+        ttk.Button(button_frame, text="Search", command=self.run_search).pack(side=tk.LEFT, padx=2)
+        ttk.Button(button_frame, text="Files...", command=self.search_recording).pack(side=tk.LEFT, padx=2)
+        ttk.Button(button_frame, text="Results", command=lambda: self.search_table.show()).pack(side=tk.LEFT, padx=2)
+        self.search_count_var = tk.StringVar(value="")
+        ttk.Label(button_frame, textvariable=self.search_count_var).pack(side=tk.LEFT, padx=5)
+
+        self.search_table = DecoderTable(self.root, title="Search Results", on_select=self.show_search_result)
+        self.search_thread: Optional[threading.Thread] = None
+        self.build_search_parameters()
+
     def setup_timebase_controls(self, parent: ttk.Frame) -> None:
         """Setup timebase control section"""
         frame = ttk.LabelFrame(parent, text="Timebase", padding=5)
@@ -416,7 +573,7 @@ class OscilloscopeGUI:
         ttk.Label(rate_frame, text="Rate (Hz):").pack(side=tk.LEFT, padx=2)
         self.update_rate_var = tk.StringVar(value=str(self.auto_update_rate))
         rate_combo = ttk.Combobox(rate_frame, textvariable=self.update_rate_var, width=6,
-                                  values=['0.5', '1', '2', '5', '10', '20'])
+                                  values=['0.5', '1', '2', '5', '10', '20', '50', '100', 'Max'])
         rate_combo.pack(side=tk.LEFT, padx=5)
 
         # Number of points
@@ -438,65 +595,225 @@ class OscilloscopeGUI:
         ttk.Button(frame, text="Update Now",
                    command=self.update_waveform).pack(pady=3)
 
+    def setup_display_controls(self, parent: ttk.Frame) -> None:
+        """Setup display (persistence) control section"""
+        frame = ttk.LabelFrame(parent, text="Display", padding=5)
+        frame.pack(fill=tk.X, pady=3)
+
+        # Persistence mode
+        mode_frame = ttk.Frame(frame)
+        mode_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(mode_frame, text="Persistence:").pack(side=tk.LEFT, padx=2)
+        self.persistence_mode_var = tk.StringVar(value=self.config.get('display.persistence_mode', 'Off'))
+        mode_combo = ttk.Combobox(mode_frame, textvariable=self.persistence_mode_var, width=8,
+                                  values=['Off', 'Behind', 'Only'], state='readonly')
+        mode_combo.pack(side=tk.LEFT, padx=5)
+        mode_combo.bind('<<ComboboxSelected>>', lambda e: self.update_persistence_mode())
+
+        # Decay time
+        decay_frame = ttk.Frame(frame)
+        decay_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(decay_frame, text="Decay (s):").pack(side=tk.LEFT, padx=2)
+        self.persistence_decay_var = tk.StringVar(value=str(self.config.get('display.persistence_decay', 'Infinite')))
+        decay_combo = ttk.Combobox(decay_frame, textvariable=self.persistence_decay_var, width=8,
+                                   values=['Infinite', '0.5', '1', '2', '5', '10', '30'])
+        decay_combo.pack(side=tk.LEFT, padx=5)
+        decay_combo.bind('<<ComboboxSelected>>', lambda e: self.update_persistence_decay())
+        decay_combo.bind('<Return>', lambda e: self.update_persistence_decay())
+
+        ttk.Button(frame, text="Clear Persistence", command=self.clear_persistence).pack(pady=3)
+
+        # Live view renderer: matplotlib for interactive analysis, raster for fast live viewing
+        view_frame = ttk.Frame(frame)
+        view_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(view_frame, text="Live view:").pack(side=tk.LEFT, padx=2)
+        self.live_view_var = tk.StringVar(value=self.config.get('display.live_view', 'Matplotlib'))
+        for view in ['Matplotlib', 'Raster']:
+            ttk.Radiobutton(view_frame, text=view, variable=self.live_view_var, value=view,
+                            command=self.update_live_view).pack(side=tk.LEFT, padx=2)
+
+    def setup_spectrum_controls(self, parent: ttk.Frame) -> None:
+        """Setup spectrum (FFT) control section"""
+        frame = ttk.LabelFrame(parent, text="Spectrum", padding=5)
+        frame.pack(fill=tk.X, pady=3)
+
+        # Window function
+        window_frame = ttk.Frame(frame)
+        window_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(window_frame, text="Window:").pack(side=tk.LEFT, padx=2)
+        self.fft_window_var = tk.StringVar(value=self.config.get('spectrum.window', 'Hann'))
+        window_combo = ttk.Combobox(window_frame, textvariable=self.fft_window_var, width=10,
+                                    values=list(WINDOW_COEFFICIENTS), state='readonly')
+        window_combo.pack(side=tk.LEFT, padx=5)
+        window_combo.bind('<<ComboboxSelected>>', lambda e: self.update_fft_window())
+
+        # Averaging mode
+        avg_frame = ttk.Frame(frame)
+        avg_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(avg_frame, text="Average:").pack(side=tk.LEFT, padx=2)
+        self.fft_average_var = tk.StringVar(value=self.config.get('spectrum.averaging', 'None'))
+        avg_combo = ttk.Combobox(avg_frame, textvariable=self.fft_average_var, width=10,
+                                 values=AVERAGING_MODES, state='readonly')
+        avg_combo.pack(side=tk.LEFT, padx=5)
+        avg_combo.bind('<<ComboboxSelected>>', lambda e: self.update_fft_averaging())
+
+        # Linear count and exponential weight
+        param_frame = ttk.Frame(frame)
+        param_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(param_frame, text="N:").pack(side=tk.LEFT, padx=2)
+        self.fft_average_count_var = tk.StringVar(value=str(self.config.get('spectrum.average_count', 16)))
+        count_combo = ttk.Combobox(param_frame, textvariable=self.fft_average_count_var, width=5,
+                                   values=['4', '8', '16', '32', '64', '128', '256'])
+        count_combo.pack(side=tk.LEFT, padx=2)
+        count_combo.bind('<<ComboboxSelected>>', lambda e: self.update_fft_averaging())
+        count_combo.bind('<Return>', lambda e: self.update_fft_averaging())
+        ttk.Label(param_frame, text="α:").pack(side=tk.LEFT, padx=2)
+        self.fft_average_alpha_var = tk.StringVar(value=str(self.config.get('spectrum.average_alpha', 0.1)))
+        alpha_entry = ttk.Entry(param_frame, textvariable=self.fft_average_alpha_var, width=6)
+        alpha_entry.pack(side=tk.LEFT, padx=2)
+        alpha_entry.bind('<Return>', lambda e: self.update_fft_averaging())
+
+        ttk.Button(frame, text="Reset Average", command=self.reset_fft_averaging).pack(pady=3)
+
+        # Harmonic analysis (THD, SINAD, SNR, ENOB) in the measurements panel
+        harmonic_frame = ttk.Frame(frame)
+        harmonic_frame.pack(fill=tk.X, pady=2)
+        self.harmonics_enabled_var = tk.BooleanVar(value=False)
+        ttk.Checkbutton(harmonic_frame, text="Harmonics up to", variable=self.harmonics_enabled_var,
+                        command=self.toggle_harmonic_analysis).pack(side=tk.LEFT, padx=2)
+        self.harmonic_count_var = tk.StringVar(value=str(self.config.get('spectrum.harmonics', 10)))
+        harmonic_combo = ttk.Combobox(harmonic_frame, textvariable=self.harmonic_count_var, width=4,
+                                      values=['3', '5', '10', '20', '50'])
+        harmonic_combo.pack(side=tk.LEFT, padx=2)
+        harmonic_combo.bind('<<ComboboxSelected>>', lambda e: self.toggle_harmonic_analysis())
+        harmonic_combo.bind('<Return>', lambda e: self.toggle_harmonic_analysis())
+
+        # Waterfall source channel
+        waterfall_frame = ttk.Frame(frame)
+        waterfall_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(waterfall_frame, text="Waterfall:").pack(side=tk.LEFT, padx=2)
+        self.waterfall_source_var = tk.StringVar(value=self.config.get('spectrum.waterfall_source', 'Off'))
+        waterfall_combo = ttk.Combobox(waterfall_frame, textvariable=self.waterfall_source_var, width=6,
+                                       values=['Off', 'CH1', 'CH2', 'CH3', 'CH4'], state='readonly')
+        waterfall_combo.pack(side=tk.LEFT, padx=5)
+        waterfall_combo.bind('<<ComboboxSelected>>', lambda e: self.update_waterfall_source())
+
+        # Welch PSD of a deep-memory record, computed while it is transferred
+        ttk.Separator(frame, orient=tk.HORIZONTAL).pack(fill=tk.X, pady=4)
+        psd_frame = ttk.Frame(frame)
+        psd_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(psd_frame, text="PSD:").pack(side=tk.LEFT, padx=2)
+        self.psd_source_var = tk.StringVar(value='CH1')
+        ttk.Combobox(psd_frame, textvariable=self.psd_source_var, width=5,
+                     values=['CH1', 'CH2', 'CH3', 'CH4'], state='readonly').pack(side=tk.LEFT, padx=2)
+        self.psd_points_var = tk.StringVar(value=str(self.config.get('spectrum.psd_points', 1000000)))
+        ttk.Combobox(psd_frame, textvariable=self.psd_points_var, width=9,
+                     values=['100000', '1000000', '10000000', '50000000']).pack(side=tk.LEFT, padx=2)
+
+        segment_frame = ttk.Frame(frame)
+        segment_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(segment_frame, text="Segment:").pack(side=tk.LEFT, padx=2)
+        self.psd_segment_var = tk.StringVar(value=str(self.config.get('spectrum.psd_segment', 65536)))
+        ttk.Combobox(segment_frame, textvariable=self.psd_segment_var, width=8,
+                     values=['4096', '16384', '65536', '262144', '1048576']).pack(side=tk.LEFT, padx=5)
+
+        ttk.Button(frame, text="Deep Record PSD", command=self.compute_deep_psd).pack(pady=3)
+
+    def setup_tone_controls(self, parent: ttk.Frame) -> None:
+        """Setup tone monitor control section"""
+        frame = ttk.LabelFrame(parent, text="Tone Monitor", padding=5)
+        frame.pack(fill=tk.X, pady=3)
+
+        # Comma-separated tone frequencies
+        tones_frame = ttk.Frame(frame)
+        tones_frame.pack(fill=tk.X, pady=2)
+        ttk.Label(tones_frame, text="Tones (Hz):").pack(side=tk.LEFT, padx=2)
+        tones = self.config.get('tones.frequencies', [50.0, 100.0, 150.0])
+        self.tone_freqs_var = tk.StringVar(value=', '.join(f"{f:g}" for f in tones))
+        tones_entry = ttk.Entry(tones_frame, textvariable=self.tone_freqs_var, width=14)
+        tones_entry.pack(side=tk.LEFT, padx=5)
+        tones_entry.bind('<Return>', lambda e: self.update_tone_frequencies())
+
+        self.tone_enabled_var = tk.BooleanVar(value=False)
+        ttk.Checkbutton(frame, text="Monitor Tones", variable=self.tone_enabled_var,
+                        command=self.toggle_tone_monitor).pack(anchor=tk.W, pady=1)
+        self.trend_log_var = tk.BooleanVar(value=False)
+        ttk.Checkbutton(frame, text="Log Trend to CSV", variable=self.trend_log_var,
+                        command=self.toggle_trend_log).pack(anchor=tk.W, pady=1)
+
+        self.tone_enabled = False
+        self.tone_monitor = ToneMonitor(tones, self.fft_window_var.get())
+        self.tone_lock = threading.Lock()
+        self.trend_logger: Optional[TrendLogger] = None
+        self.pipeline.add_stage(self.monitor_tones)
+
     def setup_waveform_display(self, parent: ttk.Frame) -> None:
         """Setup waveform display area"""
-        frame = ttk.LabelFrame(parent, text="Waveform Display", padding=5)
+        # Collapsible header
+        header_frame = ttk.Frame(parent)
+        header_frame.pack(fill=tk.X)
+
+        collapse_btn = ttk.Button(header_frame, text="▼", width=3,
+                                  command=lambda: self.toggle_section('display'))
+        collapse_btn.pack(side=tk.LEFT)
+        ttk.Label(header_frame, text="Waveform Display", font=('Arial', 10, 'bold')).pack(side=tk.LEFT, padx=5)
+
+        frame = ttk.LabelFrame(parent, text="", padding=5)
         frame.pack(fill=tk.BOTH, expand=True, pady=(0, 5))
+        self.sections_collapsed['display'] = {'btn': collapse_btn, 'frame': frame, 'collapsed': False}
+        self.display_frame = frame
+        self.raster_view: Optional[RasterWaveformView] = None
 
-        # Create matplotlib figure with 2 subplots
-        self.fig = Figure(figsize=(8, 6), dpi=100, facecolor='black')
-        
-        # Analog waveform subplot (top)
-        self.ax = self.fig.add_subplot(211, facecolor='#001a00')
-        self.ax.grid(True, color='#003300', linestyle='-', linewidth=0.5)
-        self.ax.set_xlabel('Time', color='white', fontsize=9)
-        self.ax.set_ylabel('Voltage (V)', color='white', fontsize=9)
-        self.ax.tick_params(colors='white', labelsize=8)
-        self.ax.spines['bottom'].set_color('white')
-        self.ax.spines['top'].set_color('white')
-        self.ax.spines['left'].set_color('white')
-        self.ax.spines['right'].set_color('white')
-
-        # Digital waveform subplot (bottom)
-        self.ax_digital = self.fig.add_subplot(212, facecolor='#001a00')
-        self.ax_digital.grid(True, color='#003300', linestyle='-', linewidth=0.5)
-        self.ax_digital.set_xlabel('Time', color='white', fontsize=9)
-        self.ax_digital.set_ylabel('Digital', color='white', fontsize=9)
-        self.ax_digital.tick_params(colors='white', labelsize=8)
-        self.ax_digital.spines['bottom'].set_color('white')
-        self.ax_digital.spines['top'].set_color('white')
-        self.ax_digital.spines['left'].set_color('white')
-        self.ax_digital.spines['right'].set_color('white')
-        self.ax_digital.set_ylim(-1, 16)
-        self.ax_digital.set_yticks(range(16))
-        self.ax_digital.set_yticklabels([f'D{i}' for i in range(16)])
-
-        self.fig.tight_layout()
+        # Create matplotlib figure with analog and digital subplots
+        self.fig, self.ax, self.ax_digital = create_waveform_figure(figsize=(8, 6), dpi=100)
 
         # Create canvas
         self.canvas = FigureCanvasTkAgg(self.fig, master=frame)
         self.canvas.draw()
-        self.canvas.get_tk_widget().pack(fill=tk.BOTH, expand=True)
-
-        # Store line objects for each analog channel
-        self.waveform_lines = {}
-        colors = ['#00ff00', '#ffff00', '#00ffff', '#ff00ff']
-        for i in range(1, 5):
-            line, = self.ax.plot([], [], color=colors[i-1], linewidth=1.5, label=f'CH{i}')
-            self.waveform_lines[i] = line
-
-        self.ax.legend(loc='upper right', facecolor='black', edgecolor='white',
-                       labelcolor='white', fontsize=8)
-
-        # Store line objects for each digital channel
-        self.digital_lines = {}
-        digital_colors = ['#00ff00', '#ffff00', '#00ffff', '#ff00ff', '#ff8800', '#00ff88',
-                         '#8800ff', '#ff0088', '#88ff00', '#0088ff', '#ff8888', '#88ff88',
-                         '#8888ff', '#ffff88', '#ff88ff', '#88ffff']
-        for i in range(16):
-            line, = self.ax_digital.plot([], [], color=digital_colors[i], linewidth=1.0, 
-                                         drawstyle='steps-post', label=f'D{i}')
-            self.digital_lines[i] = line
+        canvas_widget = self.canvas.get_tk_widget()
+        canvas_widget.pack(fill=tk.BOTH, expand=True)
+
+        # Track visibility so rendering can pause when nobody can see the plot
+        self.root.bind('<Unmap>', self.on_window_visibility, add='+')
+        self.root.bind('<Map>', self.on_window_visibility, add='+')
+        canvas_widget.bind('<Unmap>', self.on_canvas_visibility, add='+')
+        canvas_widget.bind('<Map>', self.on_canvas_visibility, add='+')
+        canvas_widget.bind('<Visibility>', self.on_canvas_visibility, add='+')
+
+        # Store line objects for each analog and digital channel
+        self.waveform_lines, self.digital_lines = create_trace_lines(self.ax, self.ax_digital)
+
+        # Persistence histograms per analog channel; images are created on first use
+        time_bins = self.config.get('display.persistence_time_bins', 500)
+        voltage_bins = self.config.get('display.persistence_voltage_bins', 256)
+        self.persistence = {ch: PersistenceHistogram(time_bins, voltage_bins) for ch in range(1, 5)}
+        self.persistence_images = {}
+        self.update_persistence_decay()
+        self.pipeline.add_stage(self.accumulate_persistence)
+
+        # Spectrum pane, shown below the digital subplot by the FFT toolbar button
+        self.ax_fft = create_spectrum_axes(self.fig)
+        self.spectrum_lines = create_spectrum_lines(self.ax_fft)
+        self.fft_enabled = False
+        self.spectrum_analyzer = SpectrumAnalyzer(self.fft_window_var.get())
+        self.spectrum_averager = SpectrumAverager()
+        self.spectrum_display = {}
+        self.harmonics_enabled = False
+        self.harmonic_count = 10
+        self.harmonic_results = {}
+        self.spectrum_lock = threading.Lock()
+        self.update_fft_averaging()
+        self.pipeline.add_stage(self.compute_spectrum)
+
+        # Waterfall of one channel's unaveraged spectra, below the spectrum pane
+        waterfall_rows = self.config.get('spectrum.waterfall_rows', 200)
+        self.ax_waterfall, self.waterfall_image = create_waterfall_axes(self.fig, waterfall_rows)
+        self.spectrogram = SpectrogramBuffer(waterfall_rows)
+        source = self.waterfall_source_var.get()
+        self.waterfall_channel = None if source == 'Off' else int(source[2:])
+
+        if self.live_view_var.get() == 'Raster':
+            self.update_live_view()
 
     def setup_measurements_panel(self, parent: ttk.Frame) -> None:
         """Setup measurements display panel"""
@@ -522,10 +839,117 @@ class OscilloscopeGUI:
                 ttk.Label(meas_frame, textvariable=var, width=10,
                           relief=tk.SUNKEN).pack(side=tk.LEFT, fill=tk.X, expand=True)
 
+            # Computed from the spectrum of every frame when harmonic analysis is on
+            for meas in ['THD', 'SINAD', 'SNR', 'ENOB']:
+                meas_frame = ttk.Frame(ch_frame)
+                meas_frame.pack(fill=tk.X, pady=1)
+
+                ttk.Label(meas_frame, text=f"{meas}:", width=5).pack(side=tk.LEFT)
+                var = tk.StringVar(value="---")
+                self.measurement_vars[f'ch{ch}_{meas}'] = var
+                ttk.Label(meas_frame, textvariable=var, width=10,
+                          relief=tk.SUNKEN).pack(side=tk.LEFT, fill=tk.X, expand=True)
+
+            # Tone monitor results, one line per tone
+            var = tk.StringVar(value="")
+            self.measurement_vars[f'ch{ch}_TONES'] = var
+            ttk.Label(ch_frame, textvariable=var, justify=tk.LEFT, anchor=tk.W).pack(fill=tk.X, pady=1)
+
+        # Bus statistics of the active protocol decoder (frame rate, errors, load)
+        bus_frame = ttk.LabelFrame(frame, text="Bus")
+        bus_frame.pack(side=tk.LEFT, fill=tk.BOTH, expand=True, padx=2)
+        var = tk.StringVar(value="")
+        self.measurement_vars['BUS'] = var
+        ttk.Label(bus_frame, textvariable=var, justify=tk.LEFT, anchor=tk.W).pack(fill=tk.X, pady=1)
+
         # Update measurements button
         ttk.Button(frame, text="Update Meas",
                    command=self.update_measurements).pack(pady=3)
 
+    def toggle_section(self, name: str) -> None:
+        """Collapse or expand a section registered in sections_collapsed"""
+        section = self.sections_collapsed[name]
+        frame = section['frame']
+        if section['collapsed']:
+            frame.pack(after=section['btn'].master, **section['pack_info'])
+            section['btn'].config(text="▼")
+        else:
+            section['pack_info'] = {k: v for k, v in frame.pack_info().items() if k != 'in'}
+            frame.pack_forget()
+            section['btn'].config(text="▶")
+        section['collapsed'] = not section['collapsed']
+        logger.debug(f"Section '{name}' {'collapsed' if section['collapsed'] else 'expanded'}")
+
+    # Render suspension methods
+    def on_window_visibility(self, event: tk.Event) -> None:
+        """Track minimize/restore of the main window"""
+        if event.widget is not self.root:
+            return  # Toplevel bindings also fire for every child widget
+        self.window_mapped = event.type == tk.EventType.Map
+        self.update_render_suspension()
+
+    def on_canvas_visibility(self, event: tk.Event) -> None:
+        """Track the plot widget being hidden, collapsed or covered by other windows"""
+        if event.widget is not self.active_display_widget():
+            return
+        if event.type == tk.EventType.Visibility:
+            self.canvas_obscured = event.state == 'VisibilityFullyObscured'
+        else:
+            self.canvas_mapped = event.type == tk.EventType.Map
+            if self.canvas_mapped:
+                self.canvas_obscured = False
+        self.update_render_suspension()
+
+    def update_render_suspension(self) -> None:
+        """Pause or resume drawing; acquisition and analysis stages are unaffected"""
+        suspended = not (self.window_mapped and self.canvas_mapped) or self.canvas_obscured
+        if suspended == self.render_suspended:
+            return
+        self.render_suspended = suspended
+        if suspended:
+            logger.debug("Display hidden, rendering suspended")
+        else:
+            # Draw a single catch-up frame with whatever arrived while hidden
+            self.request_redraw()
+            logger.debug("Display visible, rendering resumed")
+
+    # Live view methods
+    def active_display_widget(self) -> tk.Widget:
+        """Widget currently showing the waveforms"""
+        if self.live_view_var.get() == 'Raster' and self.raster_view is not None:
+            return self.raster_view.widget
+        return self.canvas.get_tk_widget()
+
+    def update_live_view(self) -> None:
+        """Switch between the matplotlib figure and the raster live view"""
+        canvas_widget = self.canvas.get_tk_widget()
+        if self.live_view_var.get() == 'Raster':
+            if self.raster_view is None:
+                self.raster_view = RasterWaveformView(self.display_frame)
+                for sequence in ('<Map>', '<Unmap>', '<Visibility>'):
+                    self.raster_view.widget.bind(sequence, self.on_canvas_visibility, add='+')
+            canvas_widget.pack_forget()
+            self.raster_view.widget.pack(fill=tk.BOTH, expand=True)
+        else:
+            if self.raster_view is not None:
+                self.raster_view.widget.pack_forget()
+            canvas_widget.pack(fill=tk.BOTH, expand=True)
+            if self.pipeline.latest is not None:
+                self.render_frame(self.pipeline.latest)
+
+        # The newly shown widget reports its own visibility from here on
+        self.canvas_mapped = True
+        self.canvas_obscured = False
+        self.update_render_suspension()
+        self.request_redraw()
+        logger.debug(f"Live view set to {self.live_view_var.get()}")
+
+    def show_raster_frame(self, frame) -> None:
+        """Rasterize a frame into the live view"""
+        self.displayed_frame = frame
+        voltage_ranges = {ch: self.get_channel_voltage_range(ch) for ch in frame.analog}
+        self.raster_view.show(frame, voltage_ranges, digital=self.la_enabled_var.get())
+
     # Connection methods
     def connect_scope(self) -> None:
         """Connect to the oscilloscope"""
@@ -544,6 +968,9 @@ class OscilloscopeGUI:
 
     def disconnect_scope(self) -> None:
         """Disconnect from the oscilloscope"""
+        if self.scope_busy:
+            messagebox.showwarning("Warning", "Wait for the deep record transfer to finish")
+            return
         if self.scope:
             self.is_running = False
             time.sleep(0.5)
@@ -552,11 +979,37 @@ class OscilloscopeGUI:
             self.status_label.config(text="Disconnected", foreground="red")
             logger.info("Disconnected from oscilloscope")
 
+    def scope_ready(self, quiet: bool = False) -> bool:
+        """
+        Whether a UI action may talk to the oscilloscope now
+
+        Every UI-initiated command goes through this check, so nothing is
+        written to the VISA session while a background deep-record transfer
+        owns it.
+
+        Args:
+            quiet: Return False without a dialog (control updates while
+                disconnected); a busy session is still logged
+
+        Returns:
+            True if connected and no transfer is running
+        """
+        if not self.scope:
+            if not quiet:
+                messagebox.showwarning("Warning", "Not connected to oscilloscope")
+            return False
+        if self.scope_busy:
+            if quiet:
+                logger.warning("Setting not sent: a deep record transfer is using the oscilloscope")
+            else:
+                messagebox.showwarning("Warning", "Wait for the deep record transfer to finish")
+            return False
+        return True
+
     # Control methods
     def reset_scope(self) -> None:
         """Reset the oscilloscope"""
-        if not self.scope:
-            messagebox.showwarning("Warning", "Not connected to oscilloscope")
+        if not self.scope_ready():
             return
         try:
             self.scope.reset()
@@ -569,8 +1022,7 @@ class OscilloscopeGUI:
 
     def autoscale(self) -> None:
         """Perform autoscale"""
-        if not self.scope:
-            messagebox.showwarning("Warning", "Not connected to oscilloscope")
+        if not self.scope_ready():
             return
         try:
             self.scope.autoscale()
@@ -583,8 +1035,7 @@ class OscilloscopeGUI:
 
     def run_scope(self) -> None:
         """Start acquisition"""
-        if not self.scope:
-            messagebox.showwarning("Warning", "Not connected to oscilloscope")
+        if not self.scope_ready():
             return
         try:
             self.scope.run()
@@ -597,8 +1048,7 @@ class OscilloscopeGUI:
 
     def stop_scope(self) -> None:
         """Stop acquisition"""
-        if not self.scope:
-            messagebox.showwarning("Warning", "Not connected to oscilloscope")
+        if not self.scope_ready():
             return
         try:
             self.scope.stop()
@@ -611,8 +1061,7 @@ class OscilloscopeGUI:
 
     def single_scope(self) -> None:
         """Single acquisition"""
-        if not self.scope:
-            messagebox.showwarning("Warning", "Not connected to oscilloscope")
+        if not self.scope_ready():
             return
         try:
             self.scope.single()
@@ -625,13 +1074,15 @@ class OscilloscopeGUI:
     # Update methods for controls
     def update_channel_display(self, channel: int) -> None:
         """Update channel display state"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             state = self.channel_vars[channel].get()
             self.scope.set_channel_display(channel, state)
-            self.waveform_lines[channel].set_visible(state)
-            self.canvas.draw()
+            self.waveform_lines[channel].set_visible(state and self.persistence_mode_var.get() != 'Only')
+            if channel in self.persistence_images:
+                self.persistence_images[channel].set_visible(state and self.persistence_mode_var.get() != 'Off')
+            self.request_redraw()
             logger.debug(f"Channel {channel} display updated to {state}")
         except Exception as e:
             error_msg = f"Channel display update error: {str(e)}"
@@ -640,7 +1091,7 @@ class OscilloscopeGUI:
 
     def update_channel_scale(self, channel: int) -> None:
         """Update channel scale"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             scale_str = self.channel_vars[f'ch{channel}_scale'].get()
@@ -656,7 +1107,7 @@ class OscilloscopeGUI:
 
     def update_channel_offset(self, channel: int) -> None:
         """Update channel offset"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             offset_str = self.channel_vars[f'ch{channel}_offset'].get()
@@ -672,7 +1123,7 @@ class OscilloscopeGUI:
 
     def update_channel_coupling(self, channel: int) -> None:
         """Update channel coupling"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             coupling = self.channel_vars[f'ch{channel}_coupling'].get()
@@ -685,7 +1136,7 @@ class OscilloscopeGUI:
 
     def update_channel_probe(self, channel: int) -> None:
         """Update probe ratio"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             probe_str = self.channel_vars[f'ch{channel}_probe'].get()
@@ -699,7 +1150,7 @@ class OscilloscopeGUI:
 
     def update_timebase(self) -> None:
         """Update timebase settings"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             scale = float(self.timebase_scale_var.get())
@@ -714,7 +1165,7 @@ class OscilloscopeGUI:
 
     def update_trigger(self) -> None:
         """Update trigger settings"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             mode = self.trigger_mode_var.get()
@@ -737,7 +1188,7 @@ class OscilloscopeGUI:
 
     def force_trigger(self) -> None:
         """Force trigger"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             self.scope.force_trigger()
@@ -750,7 +1201,7 @@ class OscilloscopeGUI:
     # Logic Analyzer control methods
     def toggle_logic_analyzer(self) -> None:
         """Toggle logic analyzer display"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             state = self.la_enabled_var.get()
@@ -766,7 +1217,7 @@ class OscilloscopeGUI:
                 for line in self.digital_lines.values():
                     line.set_visible(False)
             
-            self.canvas.draw()
+            self.request_redraw()
             logger.debug(f"Logic analyzer display set to {state}")
         except Exception as e:
             error_msg = f"Logic analyzer toggle error: {str(e)}"
@@ -775,7 +1226,7 @@ class OscilloscopeGUI:
 
     def update_la_threshold(self) -> None:
         """Update logic analyzer threshold"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             threshold_type = self.la_threshold_var.get()
@@ -800,13 +1251,13 @@ class OscilloscopeGUI:
 
     def update_digital_channel_display(self, channel: int) -> None:
         """Update digital channel display state"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             state = self.digital_channel_vars[channel].get()
             self.scope.set_digital_channel_display(channel, state)
             self.digital_lines[channel].set_visible(state)
-            self.canvas.draw()
+            self.request_redraw()
             logger.debug(f"Digital channel {channel} display updated to {state}")
         except Exception as e:
             error_msg = f"Digital channel display update error: {str(e)}"
@@ -815,7 +1266,7 @@ class OscilloscopeGUI:
 
     def update_digital_label(self, channel: int) -> None:
         """Update digital channel label"""
-        if not self.scope:
+        if not self.scope_ready(quiet=True):
             return
         try:
             if not validate_digital_channel(channel):
@@ -830,7 +1281,7 @@ class OscilloscopeGUI:
             # Update the y-axis label
             labels = [self.digital_label_vars[i].get() for i in range(16)]
             self.ax_digital.set_yticklabels(labels)
-            self.canvas.draw()
+            self.request_redraw()
             
             logger.debug(f"Digital channel {channel} label updated to '{label}'")
         except Exception as e:
@@ -858,11 +1309,686 @@ class OscilloscopeGUI:
             self.digital_channel_vars[d].set(True)
             self.update_digital_channel_display(d)
 
+    # Persistence methods
+    def update_persistence_mode(self) -> None:
+        """Show persistence images behind or instead of the live traces"""
+        mode = self.persistence_mode_var.get()
+        for ch in range(1, 5):
+            enabled = self.channel_vars[ch].get()
+            self.waveform_lines[ch].set_visible(enabled and mode != 'Only')
+            if ch in self.persistence_images:
+                self.persistence_images[ch].set_visible(enabled and mode != 'Off')
+        if mode == 'Off':
+            self.clear_persistence()
+        self.request_redraw()
+        logger.debug(f"Persistence mode set to {mode}")
+
+    def update_persistence_decay(self) -> None:
+        """Update persistence decay time"""
+        decay_str = self.persistence_decay_var.get()
+        try:
+            decay = None if decay_str.strip().lower() in ('infinite', 'inf', '') else float(decay_str)
+        except ValueError:
+            logger.error(f"Invalid persistence decay: {decay_str}")
+            return
+        for hist in self.persistence.values():
+            hist.set_decay(decay)
+        logger.debug(f"Persistence decay set to {decay_str}")
+
+    def clear_persistence(self) -> None:
+        """Discard all accumulated persistence hits"""
+        with self.persistence_lock:
+            for hist in self.persistence.values():
+                hist.reset()
+        for image in self.persistence_images.values():
+            image.set_visible(False)
+
+    def get_channel_voltage_range(self, channel: int) -> tuple[float, float]:
+        """Get the on-screen voltage window of a channel (8 vertical divisions)"""
+        try:
+            scale = float(self.channel_vars[f'ch{channel}_scale'].get())
+            offset = float(self.channel_vars[f'ch{channel}_offset'].get())
+        except ValueError:
+            scale, offset = self.config.get('channels.default_scale', 1.0), 0.0
+        return -4 * scale - offset, 4 * scale - offset
+
+    def accumulate_persistence(self, frame) -> None:
+        """Acquisition pipeline stage: add every frame to the persistence histograms"""
+        if self.persistence_mode_var.get() == 'Off':
+            return
+        with self.persistence_lock:
+            for ch in frame.analog:
+                time_data, voltage_data = frame.analog_window(ch, dtype=np.float32)
+                self.persistence[ch].accumulate(time_data, voltage_data,
+                                                self.get_channel_voltage_range(ch), frame.timestamp)
+
+    def update_persistence_images(self) -> None:
+        """Push accumulated persistence histograms into their image artists"""
+        colormap = self.config.get('display.persistence_colormap', 'channel')
+        for ch, hist in self.persistence.items():
+            if not hist.frames or not self.channel_vars[ch].get():
+                continue
+            with self.persistence_lock:
+                rgba = hist.to_rgba(self.waveform_lines[ch].get_color(), colormap).copy()
+            image = self.persistence_images.get(ch)
+            if image is None:
+                image = self.ax.imshow(rgba, origin='lower', aspect='auto', extent=hist.extent,
+                                       interpolation='nearest', zorder=0)
+                self.persistence_images[ch] = image
+            else:
+                image.set_data(rgba)
+                image.set_extent(hist.extent)
+            image.set_visible(True)
+
+    # Spectrum methods
+    def toggle_fft_display(self) -> None:
+        """Show or hide the spectrum pane"""
+        self.fft_enabled = not self.fft_enabled
+        self.update_spectrum_layout()
+        latest = self.pipeline.latest
+        if self.fft_enabled and latest is not None:
+            # Fill the pane right away instead of waiting for the next acquisition
+            self.compute_spectrum(latest)
+            self.update_spectrum_lines()
+        self.request_redraw()
+        logger.debug(f"FFT display set to {self.fft_enabled}")
+
+    def update_spectrum_layout(self) -> None:
+        """Lay out the spectrum and waterfall rows for the current settings"""
+        set_spectrum_visible(self.fig, self.ax, self.ax_digital, self.ax_fft, self.fft_enabled,
+                             self.ax_waterfall, self.waterfall_channel is not None)
+
+    def update_waterfall_source(self) -> None:
+        """Select the channel shown in the waterfall (restarts its history)"""
+        source = self.waterfall_source_var.get()
+        with self.spectrum_lock:
+            self.waterfall_channel = None if source == 'Off' else int(source[2:])
+            self.spectrogram.reset()
+        self.update_spectrum_layout()
+        self.request_redraw()
+        logger.debug(f"Waterfall source set to {source}")
+
+    def update_fft_window(self) -> None:
+        """Update FFT window function"""
+        window = self.fft_window_var.get()
+        with self.spectrum_lock:
+            self.spectrum_analyzer.set_window(window)
+            self.spectrum_averager.reset()  # Windows differ in noise bandwidth
+        with self.tone_lock:
+            self.tone_monitor.set_window(window)
+        logger.debug(f"FFT window set to {window}")
+
+    def update_fft_averaging(self) -> None:
+        """Apply spectrum averaging settings (restarts the average)"""
+        mode = self.fft_average_var.get()
+        try:
+            count = int(self.fft_average_count_var.get())
+            alpha = float(self.fft_average_alpha_var.get())
+            with self.spectrum_lock:
+                self.spectrum_averager.configure(mode, count, alpha)
+                self.spectrum_display.clear()
+        except ValueError as e:
+            messagebox.showerror("Error", f"Invalid averaging settings: {e}")
+            return
+        logger.debug(f"FFT averaging set to {mode} (N={count}, alpha={alpha})")
+
+    def reset_fft_averaging(self) -> None:
+        """Restart spectrum averaging on every channel"""
+        with self.spectrum_lock:
+            self.spectrum_averager.reset()
+            self.spectrum_display.clear()
+        self.request_redraw()
+
+    def toggle_harmonic_analysis(self) -> None:
+        """Apply harmonic analysis settings"""
+        try:
+            count = int(self.harmonic_count_var.get())
+            if count < 2:
+                raise ValueError("at least the 2nd harmonic is needed")
+        except ValueError as e:
+            messagebox.showerror("Error", f"Invalid harmonic count: {e}")
+            return
+        with self.spectrum_lock:
+            self.harmonic_count = count
+            self.harmonics_enabled = self.harmonics_enabled_var.get()
+            self.harmonic_results = {}
+        latest = self.pipeline.latest
+        if self.harmonics_enabled and latest is not None:
+            self.compute_spectrum(latest)
+        self.update_harmonic_display()
+
+    def compute_spectrum(self, frame) -> None:
+        """Acquisition pipeline stage: spectra and harmonic analysis of every frame, when enabled"""
+        if not (self.fft_enabled or self.harmonics_enabled):
+            return
+        with self.spectrum_lock:
+            for ch, (freqs, magnitude) in self.spectrum_analyzer.process(frame).items():
+                if self.harmonics_enabled:
+                    # Reuses the transform just computed, no extra FFT
+                    self.harmonic_results[ch] = self.spectrum_analyzer.harmonics(ch, self.harmonic_count)
+                if not self.fft_enabled:
+                    continue
+                self.spectrum_display[ch] = (freqs, self.spectrum_averager.update(ch, freqs, magnitude))
+                if ch == self.waterfall_channel:
+                    self.spectrogram.push(freqs, magnitude)
+
+    def update_harmonic_display(self) -> None:
+        """Show the newest harmonic analysis results in the measurements panel"""
+        with self.spectrum_lock:
+            results = dict(self.harmonic_results)
+        for ch in range(1, 5):
+            result = results.get(ch)
+            for meas, key in [('THD', 'thd'), ('SINAD', 'sinad'), ('SNR', 'snr'), ('ENOB', 'enob')]:
+                text = "---" if result is None else format_measurement_value(result[key], meas)
+                var = self.measurement_vars[f'ch{ch}_{meas}']
+                if var.get() != text:
+                    var.set(text)
+
+    def update_spectrum_lines(self) -> None:
+        """Push the newest spectra into the spectrum line artists"""
+        with self.spectrum_lock:
+            for ch, line in self.spectrum_lines.items():
+                spectrum = self.spectrum_display.get(ch)
+                visible = spectrum is not None and self.channel_vars[ch].get()
+                if visible:
+                    freqs, magnitude = spectrum
+                    line.set_data(freqs, magnitude.copy())
+                line.set_visible(visible)
+        self.ax_fft.relim(visible_only=True)
+        self.ax_fft.autoscale_view(scaley=False)
+
+        if self.waterfall_channel is not None:
+            with self.spectrum_lock:
+                freqs = self.spectrogram.freqs
+                if freqs is not None and self.spectrogram.count:
+                    # set_data copies the view, so the acquisition thread may keep pushing
+                    self.waterfall_image.set_data(self.spectrogram.view())
+                    self.waterfall_image.set_extent((freqs[0], freqs[-1], -self.spectrogram.rows, 0))
+                    self.ax_waterfall.set_xlim(self.ax_fft.get_xlim())
+
+    def compute_deep_psd(self) -> None:
+        """Read a deep-memory record in chunks and show its Welch PSD"""
+        if not self.scope_ready():
+            return
+        if self.is_running:
+            messagebox.showwarning("Warning", "Stop auto update before reading a deep record")
+            return
+        try:
+            channel = int(self.psd_source_var.get()[2:])
+            points = int(self.psd_points_var.get())
+            welch = StreamingWelch(int(self.psd_segment_var.get()), 0.5, self.fft_window_var.get())
+        except ValueError as e:
+            messagebox.showerror("Error", f"Invalid PSD settings: {e}")
+            return
+
+        scope = self.scope
+
+        def worker():
+            was_running = None
+            try:
+                was_running = scope.get_trigger_status() != 'STOP'
+                scope.stop()
+                preamble, chunks = scope.read_waveform_chunks(channel, points)
+                # The next chunk transfers while the current one is being folded in
+                for chunk in prefetch(chunks):
+                    welch.feed(chunk)
+                freqs, psd = welch.psd(preamble['x_increment'])
+                logger.info(f"PSD of CH{channel}: {welch.samples} samples, {welch.segments} segments")
+                self.root.after(0, lambda: self.show_psd_window(channel, freqs, psd, welch.segments))
+            except Exception as e:
+                logger.error(f"Deep record PSD error: {e}")
+                error = f"Deep record PSD failed: {e}"
+                self.root.after(0, lambda: messagebox.showerror("Error", error))
+            finally:
+                try:
+                    if was_running:
+                        scope.run()
+                except Exception as e:
+                    logger.error(f"Failed to restart acquisition after deep record: {e}")
+                self.scope_busy = False
+
+        self.scope_busy = True
+        threading.Thread(target=worker, daemon=True).start()
+
+    def show_psd_window(self, channel: int, freqs: np.ndarray, psd: np.ndarray, segments: int) -> None:
+        """Plot a PSD in its own window"""
+        window = tk.Toplevel(self.root)
+        window.title(f"CH{channel} Power Spectral Density ({segments} segments)")
+        fig = Figure(figsize=(8, 4), dpi=100, facecolor='black')
+        ax = fig.add_subplot(111)
+        style_axes(ax, 'PSD (dB V²/Hz)', xlabel='Frequency (Hz)')
+        ax.plot(freqs[1:], 10 * np.log10(np.maximum(psd[1:], 1e-30)),
+                color=ANALOG_COLORS[channel - 1], linewidth=0.8)
+        ax.set_xscale('log')
+        fig.tight_layout()
+        canvas = FigureCanvasTkAgg(fig, master=window)
+        canvas.get_tk_widget().pack(fill=tk.BOTH, expand=True)
+        canvas.draw()
+
+    # Protocol decoder methods
+    def decoder_channel_choices(self, optional: bool = False) -> list:
+        """Decoder source choices: D0-D15 (with their labels) and analog CH1-CH4"""
+        choices = ['None'] if optional else []
+        for d in range(16):
+            label = self.digital_label_vars[d].get()
+            choices.append(f"D{d}" if label in ('', f"D{d}") else f"D{d} {label}")
+        return choices + ['CH1', 'CH2', 'CH3', 'CH4']
+
+    def build_parameter_widgets(self, parent: ttk.Frame, parameters: list, saved: dict) -> dict:
+        """
+        Create one labelled combobox per parameter (decoders and searches)
+
+        Args:
+            parent: Frame to fill; existing children are removed
+            parameters: Parameter descriptions
+            saved: Previously used values keyed by Parameter.key
+
+        Returns:
+            StringVars keyed by Parameter.key
+        """
+        for child in parent.winfo_children():
+            child.destroy()
+        param_vars = {}
+        for parameter in parameters:
+            row = ttk.Frame(parent)
+            row.pack(fill=tk.X, pady=1)
+            ttk.Label(row, text=f"{parameter.label}:", width=10).pack(side=tk.LEFT, padx=2)
+            var = tk.StringVar(value=saved.get(parameter.key, parameter.default))
+            if parameter.channel:
+                combo = ttk.Combobox(row, textvariable=var, width=10, state='readonly',
+                                     values=self.decoder_channel_choices(parameter.optional))
+                combo.configure(postcommand=lambda c=combo, o=parameter.optional:
+                                c.configure(values=self.decoder_channel_choices(o)))
+            else:
+                combo = ttk.Combobox(row, textvariable=var, width=10, values=list(parameter.choices or []))
+            combo.pack(side=tk.LEFT, padx=2)
+            param_vars[parameter.key] = var
+        return param_vars
+
+    @staticmethod
+    def read_parameter_values(parameters: list, param_vars: dict) -> dict:
+        """Read parameter widgets; channel choices are reduced to their source name"""
+        settings = {}
+        for parameter in parameters:
+            value = param_vars[parameter.key].get()
+            settings[parameter.key] = value.split()[0] if parameter.channel and value else value
+        return settings
+
+    def build_decoder_parameters(self) -> None:
+        """Create the setting widgets of the selected protocol"""
+        decoder = DECODERS[self.decoder_protocol_var.get()]
+        self.decoder_param_vars = self.build_parameter_widgets(
+            self.decoder_params_frame, decoder.parameters, self.config.get(f'decoder.{decoder.name}', {}))
+
+    def get_decoder_settings(self) -> tuple:
+        """
+        Snapshot the decoder settings from the GUI
+
+        Returns:
+            Tuple of (decoder, settings dict, analog threshold)
+        """
+        decoder = DECODERS[self.decoder_protocol_var.get()]
+        settings = self.read_parameter_values(decoder.parameters, self.decoder_param_vars)
+        self.config.set(f'decoder.{decoder.name}', dict(settings))
+        return decoder, settings, self.get_analog_threshold()
+
+    def get_analog_threshold(self) -> tuple:
+        """
+        Comparator levels for analog sources of decoders, searches and timing
+
+        Returns:
+            Tuple of (falling, rising) thresholds in volts
+        """
+        hysteresis = float(self.decoder_hysteresis_var.get())
+        threshold = parse_logic_threshold(self.decoder_threshold_var.get(), hysteresis)
+        self.config.set('decoder.analog_threshold', self.decoder_threshold_var.get().strip())
+        self.config.set('decoder.hysteresis', hysteresis)
+        return threshold
+
+    def decode_protocol(self) -> None:
+        """Decode the newest frame once"""
+        frame = self.pipeline.latest
+        if frame is None:
+            messagebox.showwarning("Warning", "No captured frame to decode")
+            return
+        try:
+            decoder, settings, threshold = self.get_decoder_settings()
+            start = time.perf_counter()
+            annotations = decoder.decode(frame, settings, threshold)
+            statistics = decoder.statistics(annotations, frame_duration(frame))
+            logger.info(f"{decoder.name}: {len(annotations)} items decoded in "
+                        f"{(time.perf_counter() - start) * 1e3:.1f} ms")
+        except Exception as e:
+            messagebox.showerror("Error", f"Decode failed: {e}")
+            logger.error(f"Decode error: {e}")
+            return
+        with self.decoder_lock:
+            self.decoder_annotations = annotations
+            self.decoder_statistics = statistics
+            self.decoder_updated = True
+        self.update_decoder_display()
+
+    def toggle_live_decode(self) -> None:
+        """Decode every acquired frame with the current settings"""
+        if self.decoder_live_var.get():
+            try:
+                settings = self.get_decoder_settings()
+            except ValueError as e:
+                self.decoder_live_var.set(False)
+                messagebox.showerror("Error", f"Invalid decoder settings: {e}")
+                return
+            with self.decoder_lock:
+                self.decoder_settings = settings
+        else:
+            with self.decoder_lock:
+                self.decoder_settings = None
+
+    def decode_frame(self, frame) -> None:
+        """Acquisition pipeline stage: decode every frame while live decoding is on"""
+        settings = self.decoder_settings
+        if settings is None:
+            return
+        decoder, values, threshold = settings
+        annotations = decoder.decode(frame, values, threshold)
+        statistics = decoder.statistics(annotations, frame_duration(frame))
+        with self.decoder_lock:
+            self.decoder_annotations = annotations
+            self.decoder_statistics = statistics
+            self.decoder_updated = True
+
+    def update_decoder_display(self) -> None:
+        """Redraw the decoder overlay and table if new results arrived"""
+        with self.decoder_lock:
+            if not self.decoder_updated:
+                return
+            self.decoder_updated = False
+            annotations = self.decoder_annotations
+            statistics = self.decoder_statistics
+        self.measurement_vars['BUS'].set('\n'.join(f"{name}: {value:.4g}" for name, value in statistics.items()))
+        for artist in self.decoder_artists:
+            artist.remove()
+        self.decoder_artists = draw_annotations(self.ax_digital, annotations, self.ax_digital.get_xlim())
+        self.decoder_table.set_annotations(annotations)
+        self.request_redraw()
+
+    def show_decoder_table(self) -> None:
+        """Open the decoded results table"""
+        self.decoder_table.show()
+
+    def show_decoder_cursor(self, annotation) -> None:
+        """Mark a decoded item selected in the table and bring it into view"""
+        t = annotation.start
+        if self.decoder_cursor:
+            for line in self.decoder_cursor:
+                line.set_xdata([t, t])
+        else:
+            self.decoder_cursor = [axis.axvline(t, color='white', linestyle='--', linewidth=0.8)
+                                   for axis in (self.ax, self.ax_digital)]
+
+        for axis in (self.ax, self.ax_digital):
+            x0, x1 = axis.get_xlim()
+            if not x0 <= t <= x1:
+                half = (x1 - x0) / 2
+                axis.set_xlim(t - half, t + half)
+        # The overlay only holds labels for the previous view
+        with self.decoder_lock:
+            annotations = self.decoder_annotations
+        for artist in self.decoder_artists:
+            artist.remove()
+        self.decoder_artists = draw_annotations(self.ax_digital, annotations, self.ax_digital.get_xlim())
+        self.request_redraw()
+
+    def clear_decoder(self) -> None:
+        """Remove decoded results"""
+        with self.decoder_lock:
+            self.decoder_annotations = []
+            self.decoder_statistics = {}
+            self.decoder_updated = True
+        for line in self.decoder_cursor:
+            line.remove()
+        self.decoder_cursor = []
+        self.update_decoder_display()
+
+    # Logic-analyzer timing measurement methods
+    def toggle_logic_measurements(self) -> None:
+        """Enable or disable timing measurements of every frame"""
+        threshold = None
+        if self.logic_measure_analog_var.get():
+            try:
+                threshold = self.get_analog_threshold()
+            except ValueError as e:
+                self.logic_measure_analog_var.set(False)
+                messagebox.showerror("Error", f"Invalid analog threshold: {e}")
+        with self.logic_lock:
+            self.logic_measure_threshold = threshold
+        self.logic_measure_enabled = self.logic_measure_var.get()
+        if self.logic_measure_enabled:
+            latest = self.pipeline.latest
+            if latest is not None:
+                with self.logic_lock:
+                    self.logic_measurements.process(latest, threshold)
+            self.show_logic_measurements()
+
+    def measure_logic_frame(self, frame) -> None:
+        """Acquisition pipeline stage: timing of every digital channel, when enabled"""
+        if not self.logic_measure_enabled:
+            return
+        with self.logic_lock:
+            self.logic_measurements.process(frame, self.logic_measure_threshold)
+
+    def show_logic_measurements(self) -> None:
+        """Open the digital timing table"""
+        self.logic_table.show()
+
+    def reset_logic_measurements(self) -> None:
+        """Restart the running statistics"""
+        with self.logic_lock:
+            self.logic_measurements.reset()
+        self.update_logic_measurement_display()
+
+    def update_logic_measurement_display(self) -> None:
+        """Show the newest timing values or statistics in the table"""
+        if not self.logic_table.is_open():
+            return
+        with self.logic_lock:
+            rows = self.logic_measurements.view(self.logic_table.view)
+            frames = self.logic_measurements.frames
+        labels = dict(zip(LOGIC_SOURCES, self.decoder_channel_choices()))
+        self.logic_table.set_values(rows, frames, labels)
+
+    # Search methods
+    def build_search_parameters(self) -> None:
+        """Create the setting widgets of the selected search"""
+        search = SEARCHES[self.search_type_var.get()]
+        self.search_param_vars = self.build_parameter_widgets(
+            self.search_params_frame, search.parameters, self.config.get(f'search.{search.name}', {}))
+
+    def read_search_settings(self):
+        """Selected search and its parameter values, remembered in the configuration"""
+        search = SEARCHES[self.search_type_var.get()]
+        settings = self.read_parameter_values(search.parameters, self.search_param_vars)
+        self.config.set('search.type', search.name)
+        self.config.set(f'search.{search.name}', dict(settings))
+        return search, settings
+
+    def run_search(self) -> None:
+        """Search the newest frame and list the events"""
+        frame = self.pipeline.latest
+        if frame is None:
+            messagebox.showwarning("Warning", "No captured frame to search")
+            return
+        search, settings = self.read_search_settings()
+        try:
+            start = time.perf_counter()
+            events = search.find(frame, settings, self.get_analog_threshold())
+            elapsed = time.perf_counter() - start
+        except Exception as e:
+            messagebox.showerror("Error", f"Search failed: {e}")
+            logger.error(f"Search error: {e}")
+            return
+        logger.info(f"{search.name} search: {len(events)} events in {elapsed * 1e3:.1f} ms")
+        self.search_count_var.set(f"{len(events)} events")
+        self.search_table.set_annotations(events)
+        self.search_table.show()
+
+    def search_recording(self) -> None:
+        """Search every frame of recorded capture files on a background thread and list the events"""
+        if self.search_thread is not None and self.search_thread.is_alive():
+            messagebox.showwarning("Warning", "A recording search is still running")
+            return
+        filenames = filedialog.askopenfilenames(filetypes=[("Capture files", "*.rcap"), ("All files", "*.*")])
+        if not filenames:
+            return
+        search, settings = self.read_search_settings()
+        threshold = self.get_analog_threshold()
+        self.search_count_var.set("Searching...")
+
+        def worker():
+            # Records are mapped one at a time, so memory stays bounded by a single frame
+            records, refs = itertools.tee(read_records(sorted(filenames)))
+            try:
+                start = time.perf_counter()
+                results = search_frames((record.frame() for record in records), search, settings, threshold,
+                                        keys=(record.ref for record in refs))
+                elapsed = time.perf_counter() - start
+            except Exception as e:
+                error_msg = f"Search failed: {e}"
+                logger.error(error_msg)
+                self.root.after(0, lambda: (self.search_count_var.set(""), messagebox.showerror("Error", error_msg)))
+                return
+            logger.info(f"{search.name} search: {len(results)} events in {len(filenames)} files "
+                        f"in {elapsed:.2f} s")
+            self.root.after(0, lambda: self.list_recording_results(results))
+
+        self.search_thread = threading.Thread(target=worker, daemon=True)
+        self.search_thread.start()
+
+    def list_recording_results(self, results) -> None:
+        """List the (capture.RecordRef, event) pairs of a recording search"""
+        frames = len(set(ref for ref, _ in results))
+        self.search_count_var.set(f"{len(results)} events in {frames} frames")
+        self.search_table.set_annotations([event for _, event in results], [ref for ref, _ in results])
+        self.search_table.show()
+
+    def show_search_result(self, annotation, record=None) -> None:
+        """
+        Show a search event selected in the results
+
+        Args:
+            annotation: Selected event
+            record: capture.RecordRef of the event's frame in a searched
+                recording; its frame is loaded and shown first
+        """
+        if record is not None:
+            try:
+                frame = CaptureFile(record.filename, record.offset).frame()
+            except (OSError, ValueError) as e:
+                messagebox.showerror("Error", f"Cannot load frame {record}: {e}")
+                return
+            if self.live_view_var.get() == 'Raster' and self.raster_view is not None:
+                self.show_raster_frame(frame)
+            else:
+                self.render_frame(frame)
+        self.show_decoder_cursor(annotation)
+
+    # Tone monitor methods
+    def update_tone_frequencies(self) -> None:
+        """Apply the tone frequency list"""
+        try:
+            tones = [float(f) for f in self.tone_freqs_var.get().replace(';', ',').split(',') if f.strip()]
+            with self.tone_lock:
+                self.tone_monitor.set_frequencies(tones)
+        except ValueError as e:
+            messagebox.showerror("Error", f"Invalid tone frequencies: {e}")
+            return
+        # An open trend log rolls over to a new file by itself when new tone columns appear
+        self.config.set('tones.frequencies', tones)
+        self.update_tone_display()
+        logger.debug(f"Tone frequencies set to {tones}")
+
+    def toggle_tone_monitor(self) -> None:
+        """Enable or disable tone monitoring"""
+        self.tone_enabled = self.tone_enabled_var.get()
+        if not self.tone_enabled:
+            with self.tone_lock:
+                self.tone_monitor.results = {}
+            self.update_tone_display()
+            return
+        latest = self.pipeline.latest
+        if latest is not None:
+            with self.tone_lock:
+                self.tone_monitor.process(latest)
+            self.update_tone_display()
+
+    def toggle_trend_log(self) -> None:
+        """Start or stop logging tone amplitudes of every frame to a CSV file"""
+        if self.trend_log_var.get():
+            filename = filedialog.asksaveasfilename(defaultextension=".csv",
+                                                    filetypes=[("CSV files", "*.csv"), ("All files", "*.*")])
+            if not filename:
+                self.trend_log_var.set(False)
+                return
+            try:
+                trend_logger = TrendLogger(filename)
+            except IOError as e:
+                self.trend_log_var.set(False)
+                messagebox.showerror("Error", f"Failed to open trend log: {e}")
+                return
+            with self.tone_lock:
+                self.trend_logger = trend_logger
+            if not self.tone_enabled:
+                self.tone_enabled_var.set(True)
+                self.toggle_tone_monitor()
+            logger.info(f"Logging trend to {filename}")
+        else:
+            self.close_trend_log()
+
+    def close_trend_log(self) -> None:
+        """Close the trend log, if one is open"""
+        with self.tone_lock:
+            trend_logger, self.trend_logger = self.trend_logger, None
+        if trend_logger is not None:
+            trend_logger.close()
+
+    def monitor_tones(self, frame) -> None:
+        """Acquisition pipeline stage: tone amplitudes of every frame, logged to the trend file"""
+        if not self.tone_enabled:
+            return
+        with self.tone_lock:
+            results = self.tone_monitor.process(frame)
+            if self.trend_logger is not None:
+                values = {}
+                for ch in range(1, 5):
+                    for f, amplitude in zip(self.tone_monitor.frequencies, results.get(ch, ())):
+                        values[f"CH{ch}_{f:g}Hz"] = amplitude
+                self.trend_logger.log(frame.timestamp, values)
+
+    def update_tone_display(self) -> None:
+        """Show the newest tone amplitudes in the measurements panel"""
+        with self.tone_lock:
+            frequencies = self.tone_monitor.frequencies
+            results = dict(self.tone_monitor.results)
+        for ch in range(1, 5):
+            amplitudes = results.get(ch)
+            if amplitudes is None:
+                text = ""
+            else:
+                text = '\n'.join(f"{format_measurement_value(f, 'FREQ')}: {format_measurement_value(a, 'VRMS')}"
+                                  for f, a in zip(frequencies, amplitudes))
+            var = self.measurement_vars[f'ch{ch}_TONES']
+            if var.get() != text:
+                var.set(text)
+
     # Waveform update methods
     def toggle_auto_update(self) -> None:
         """Toggle automatic waveform updates"""
         if self.auto_update_var.get():
+            if self.scope_busy:
+                self.auto_update_var.set(False)
+                messagebox.showwarning("Warning", "Wait for the deep record transfer to finish")
+                return
             self.is_running = True
+            self.pipeline.reset_rate()
             self.update_thread = threading.Thread(target=self.auto_update_loop, daemon=True)
             self.update_thread.start()
             logger.info("Auto-update started")
@@ -875,61 +2001,106 @@ class OscilloscopeGUI:
         while self.is_running:
             try:
                 self.update_waveform()
-                rate = float(self.update_rate_var.get())
-                time.sleep(1.0 / rate)
+                rate_str = self.update_rate_var.get()
+                if rate_str != 'Max':
+                    time.sleep(1.0 / float(rate_str))
             except Exception as e:
                 logger.error(f"Auto update error: {e}")
                 time.sleep(1)
 
     def update_waveform(self) -> None:
-        """Update waveform display"""
-        if not self.scope:
+        """Acquire one frame and publish it to the acquisition pipeline"""
+        if not self.scope or self.scope_busy:
             return
 
         try:
             points = int(self.points_var.get())
 
-            # Get data for each enabled analog channel
-            for ch in range(1, 5):
-                if self.channel_vars[ch].get():
-                    try:
-                        time_data, voltage_data = self.scope.get_waveform_data(ch, points)
-                        self.waveform_lines[ch].set_data(time_data, voltage_data)
-                    except Exception as e:
-                        logger.error(f"Error reading channel {ch}: {e}")
-
-            # Get data for each enabled digital channel (if LA is enabled)
+            # Get data for each enabled analog and digital (if LA is enabled) channel
+            analog_channels = [ch for ch in range(1, 5) if self.channel_vars[ch].get()]
+            digital_channels = []
             if self.la_enabled_var.get():
-                for d in range(16):
-                    if self.digital_channel_vars[d].get():
-                        try:
-                            time_data, digital_data = self.scope.get_digital_data(d, points)
-                            # Offset each digital channel vertically for display
-                            digital_data_offset = digital_data * 0.8 + d
-                            self.digital_lines[d].set_data(time_data, digital_data_offset)
-                        except Exception as e:
-                            logger.error(f"Error reading digital channel {d}: {e}")
-
-            # Auto-scale axes
-            self.ax.relim()
-            self.ax.autoscale_view()
-            
-            if self.la_enabled_var.get():
-                self.ax_digital.relim()
-                self.ax_digital.autoscale_view(scaley=False)  # Keep Y fixed for digital
-
-            # Redraw canvas
-            self.canvas.draw()
+                digital_channels = [d for d in range(16) if self.digital_channel_vars[d].get()]
+            frame = acquire_frame(self.scope, analog_channels, digital_channels, points,
+                                  sequence=self.pipeline.frames_acquired)
+            self.pipeline.submit(frame)
 
-            logger.debug("Waveform display updated")
+            logger.debug(f"Waveform frame {frame.sequence} acquired")
 
         except Exception as e:
             logger.error(f"Waveform update error: {e}")
 
+    def request_redraw(self) -> None:
+        """Schedule a canvas redraw on the next display tick"""
+        self.redraw_pending = True
+
+    def render_frame(self, frame) -> None:
+        """Load a frame into the display artists"""
+        self.displayed_frame = frame
+        update_trace_lines(frame, self.waveform_lines, self.digital_lines)
+
+        if self.persistence_mode_var.get() != 'Off':
+            self.update_persistence_images()
+
+        # Auto-scale axes
+        self.ax.relim()
+        self.ax.autoscale_view()
+
+        if self.la_enabled_var.get():
+            self.ax_digital.relim()
+            self.ax_digital.autoscale_view(scaley=False)  # Keep Y fixed for digital
+
+        if self.fft_enabled:
+            self.update_spectrum_lines()
+
+    def display_tick(self) -> None:
+        """Fixed-cadence display refresh on the Tk event loop"""
+        if self.render_suspended:
+            # Poll slowly; frames keep flowing through the pipeline meanwhile
+            self.root.after(max(self.display_interval_ms, 250), self.display_tick)
+            return
+
+        try:
+            frame = self.pipeline.take_latest()
+            if self.live_view_var.get() == 'Raster' and self.raster_view is not None:
+                # Raster live view: every display tick blits the newest frame directly
+                if frame is None and self.redraw_pending:
+                    frame = self.pipeline.latest
+                self.redraw_pending = False
+                if frame is not None:
+                    self.show_raster_frame(frame)
+            else:
+                if frame is not None:
+                    self.render_frame(frame)
+                    self.redraw_pending = True
+                if self.decoder_updated:
+                    self.update_decoder_display()
+
+                if self.redraw_pending:
+                    self.redraw_pending = False
+                    self.canvas.draw()
+
+            if frame is not None and self.tone_enabled:
+                self.update_tone_display()
+            if frame is not None and self.harmonics_enabled:
+                self.update_harmonic_display()
+            if frame is not None and self.logic_measure_enabled:
+                self.update_logic_measurement_display()
+
+            if self.recorder is not None:
+                self.update_record_display()
+
+            rate_text = f"Acq: {self.pipeline.acquisition_rate:.1f} wfm/s" if self.is_running else "Acq: 0 wfm/s"
+            if self.acq_rate_label.cget('text') != rate_text:
+                self.acq_rate_label.config(text=rate_text)
+        except Exception as e:
+            logger.error(f"Display refresh error: {e}")
+
+        self.root.after(self.display_interval_ms, self.display_tick)
+
     def update_measurements(self) -> None:
         """Update all measurements"""
-        if not self.scope:
-            messagebox.showwarning("Warning", "Not connected to oscilloscope")
+        if not self.scope_ready():
             return
 
         measurements = ['FREQ', 'VPP', 'VMAX', 'VMIN', 'VRMS', 'VAVG', 'PER', 'PWID']
@@ -951,8 +2122,7 @@ class OscilloscopeGUI:
 
     def take_screenshot(self) -> None:
         """Take oscilloscope screenshot"""
-        if not self.scope:
-            messagebox.showwarning("Warning", "Not connected to oscilloscope")
+        if not self.scope_ready():
             return
 
         filename = filedialog.asksaveasfilename(
@@ -970,83 +2140,166 @@ class OscilloscopeGUI:
                 messagebox.showerror("Error", error_msg)
                 logger.error(error_msg)
 
+    def capture_settings(self) -> dict:
+        """Instrument settings from the control panel, stored with capture files"""
+        channels = {}
+        for ch in range(1, 5):
+            channels[f"CH{ch}"] = {
+                'enabled': self.channel_vars[ch].get(),
+                'scale': self.channel_vars[f'ch{ch}_scale'].get(),
+                'offset': self.channel_vars[f'ch{ch}_offset'].get(),
+                'coupling': self.channel_vars[f'ch{ch}_coupling'].get(),
+                'probe': self.channel_vars[f'ch{ch}_probe'].get(),
+            }
+        return {
+            'channels': channels,
+            'timebase': {'scale': self.timebase_scale_var.get(), 'offset': self.timebase_offset_var.get()},
+            'trigger': {'mode': self.trigger_mode_var.get(), 'source': self.trigger_source_var.get(),
+                        'level': self.trigger_level_var.get(), 'slope': self.trigger_slope_var.get()},
+            'logic_analyzer': {'threshold': self.la_threshold_var.get(),
+                               'level': self.la_threshold_level_var.get(),
+                               'labels': {d: var.get() for d, var in self.digital_label_vars.items()}},
+        }
+
+    def toggle_recording(self) -> None:
+        """Start or stop streaming every acquired frame to capture files"""
+        if not self.record_var.get():
+            self.stop_recording()
+            return
+        filename = filedialog.asksaveasfilename(defaultextension=".rcap",
+                                                filetypes=[("Capture files", "*.rcap"), ("All files", "*.*")])
+        if not filename:
+            self.record_var.set(False)
+            return
+        max_mb = float(self.config.get('recording.max_mb', 1024))
+        max_minutes = float(self.config.get('recording.max_minutes', 60))
+        try:
+            recorder = CaptureRecorder(filename, max_bytes=int(max_mb * 1e6) if max_mb > 0 else None,
+                                       max_seconds=max_minutes * 60 if max_minutes > 0 else None,
+                                       queue_depth=int(self.config.get('recording.queue_depth', 16)),
+                                       settings=self.capture_settings())
+        except (OSError, ValueError) as e:
+            self.record_var.set(False)
+            messagebox.showerror("Error", f"Failed to start recording: {e}")
+            return
+        self.recorder = recorder
+        self.pipeline.add_stage(recorder.submit)
+        self.update_record_display()
+
+    def stop_recording(self, wait: bool = False) -> None:
+        """
+        Stop the recording, if one is running, after the queued frames are written
+
+        Args:
+            wait: Close on the calling thread (at exit); otherwise the queued
+                frames are written on a helper thread so the GUI stays responsive
+        """
+        recorder, self.recorder = self.recorder, None
+        if wait:
+            # The helpers never touch Tk, so joining them here cannot deadlock
+            for _, thread in self.closing_recorders:
+                thread.join()
+            self.closing_recorders = []
+        if recorder is None:
+            return
+        self.pipeline.remove_stage(recorder.submit)
+        self.record_var.set(False)
+        if wait:
+            recorder.close()
+            return
+        self.record_label.config(text="Rec: closing...", foreground="")
+        thread = threading.Thread(target=recorder.close, daemon=True)
+        thread.start()
+        if not self.closing_recorders:
+            self.root.after(100, self.poll_closing_recorders)
+        self.closing_recorders.append((recorder, thread))
+
+    def poll_closing_recorders(self) -> None:
+        """Report recordings whose helper thread has finished closing them"""
+        still_closing = []
+        for recorder, thread in self.closing_recorders:
+            if thread.is_alive():
+                still_closing.append((recorder, thread))
+            else:
+                self.recording_closed(recorder.status())
+        self.closing_recorders = still_closing
+        if still_closing:
+            self.root.after(100, self.poll_closing_recorders)
+
+    def recording_closed(self, status) -> None:
+        """Clear the recorder counters and report dropped frames once a recording is closed"""
+        if self.recorder is None:
+            self.record_label.config(text="")
+        if status['dropped']:
+            messagebox.showwarning("Recording", f"{status['dropped']} frames were dropped because the "
+                                                f"disk did not keep up ({status['written']} written)")
+
+    def update_record_display(self) -> None:
+        """Show the recorder counters in the toolbar"""
+        status = self.recorder.status()
+        if status['error'] is not None:
+            text = f"Rec error: {status['error']}"
+        else:
+            text = f"Rec: {status['written']} wfm, {status['bytes'] / 1e6:.0f} MB"
+            if status['dropped']:
+                text += f", {status['dropped']} dropped"
+        if self.record_label.cget('text') != text:
+            self.record_label.config(text=text, foreground="red" if status['dropped'] or status['error'] else "")
+
     def save_waveform(self) -> None:
-        """Save waveform data to CSV"""
-        if not self.scope:
-            messagebox.showwarning("Warning", "Not connected to oscilloscope")
+        """Save the displayed frame to CSV, a capture file or HDF5 on a background thread"""
+        # The pipeline may already hold a newer frame than the one on screen
+        frame = self.displayed_frame
+        if frame is None:
+            messagebox.showwarning("Warning", "No captured frame to save")
+            return
+        if self.export_thread is not None and self.export_thread.is_alive():
+            if messagebox.askyesno("Export", "An export is still running. Cancel it?"):
+                self.export_cancel.set()
             return
 
         filename = filedialog.asksaveasfilename(
             defaultextension=".csv",
-            filetypes=[("CSV files", "*.csv"), ("All files", "*.*")]
+            filetypes=[("CSV files", "*.csv"), ("Capture files", "*.rcap"), ("HDF5 files", "*.h5"),
+                       ("All files", "*.*")]
         )
+        if not filename:
+            return
 
-        if filename:
+        labels = {d: self.digital_label_vars[d].get() or f"D{d}" for d in frame.digital}
+        file_format = os.path.splitext(filename)[1].lower()
+        settings = self.capture_settings() if file_format in ('.rcap', '.h5', '.hdf5') else None
+        compression = self.config.get('export.hdf5_compression', 'gzip')
+        self.export_cancel = threading.Event()
+
+        def show_progress(fraction: float) -> None:
+            self.root.after(0, lambda: self.export_label.config(text=f"Saving {fraction:.0%}"))
+
+        def worker():
             try:
-                points = int(self.points_var.get())
-
-                with open(filename, 'w') as f:
-                    # Write header
-                    header = "Time"
-                    for ch in range(1, 5):
-                        if self.channel_vars[ch].get():
-                            header += f",CH{ch}"
-                    
-                    # Add digital channels to header if LA is enabled
-                    if self.la_enabled_var.get():
-                        for d in range(16):
-                            if self.digital_channel_vars[d].get():
-                                label = self.digital_label_vars[d].get()
-                                header += f",{label}"
-                    
-                    f.write(header + "\n")
-
-                    # Get data for enabled analog channels
-                    data = {}
-                    time_data = None
-
-                    for ch in range(1, 5):
-                        if self.channel_vars[ch].get():
-                            time_data, voltage_data = self.scope.get_waveform_data(ch, points)
-                            data[f'CH{ch}'] = voltage_data
-
-                    # Get data for enabled digital channels
-                    if self.la_enabled_var.get():
-                        for d in range(16):
-                            if self.digital_channel_vars[d].get():
-                                label = self.digital_label_vars[d].get()
-                                if time_data is None:
-                                    time_data, digital_data = self.scope.get_digital_data(d, points)
-                                else:
-                                    _, digital_data = self.scope.get_digital_data(d, points)
-                                data[label] = digital_data
-
-                    # Write data
-                    if time_data is not None:
-                        for i in range(len(time_data)):
-                            line = f"{time_data[i]}"
-                            
-                            # Add analog channel data
-                            for ch in range(1, 5):
-                                if f'CH{ch}' in data:
-                                    line += f",{data[f'CH{ch}'][i]}"
-                            
-                            # Add digital channel data
-                            if self.la_enabled_var.get():
-                                for d in range(16):
-                                    if self.digital_channel_vars[d].get():
-                                        label = self.digital_label_vars[d].get()
-                                        if label in data:
-                                            line += f",{int(data[label][i])}"
-                            
-                            f.write(line + "\n")
-
-                messagebox.showinfo("Success", f"Waveform data saved to {filename}")
-                logger.info(f"Waveform data saved to {filename}")
+                start = time.perf_counter()
+                if file_format in ('.h5', '.hdf5'):
+                    saved = write_hdf5(filename, [frame], compression, settings) > 0
+                elif settings is not None:
+                    saved = write_capture(filename, frame, settings) > 0
+                else:
+                    saved = write_csv(filename, frame, labels, progress=show_progress,
+                                      cancel=self.export_cancel) > 0
+                elapsed = time.perf_counter() - start
+                if saved:
+                    size = os.path.getsize(filename)
+                    logger.info(f"Waveform data saved to {filename}: {size / 1e6:.1f} MB in {elapsed:.2f} s")
+                    message = f"Waveform data saved to {filename}"
+                    self.root.after(0, lambda: messagebox.showinfo("Success", message))
+                self.root.after(0, lambda: self.export_label.config(text=""))
             except Exception as e:
                 error_msg = f"Save waveform error: {str(e)}"
-                messagebox.showerror("Error", error_msg)
                 logger.error(error_msg)
+                self.root.after(0, lambda: (self.export_label.config(text=""),
+                                            messagebox.showerror("Error", error_msg)))
+
+        self.export_thread = threading.Thread(target=worker, daemon=True)
+        self.export_thread.start()
 
 
 def main() -> None:
@@ -1075,6 +2328,8 @@ def main() -> None:
 
     # Save config on exit
     def on_closing():
+        app.close_trend_log()
+        app.stop_recording(wait=True)
         config.save()
         root.destroy()
 
@@ -9,6 +9,7 @@ import pyvisa
 import time
 import numpy as np
 import logging
+from typing import Iterator
 
 logger = logging.getLogger(__name__)
 
@@ -144,6 +145,10 @@ class RigolDHO954:
         self.write(":STOP")
         logger.debug("Acquisition stopped")
 
+    def get_trigger_status(self) -> str:
+        """Trigger status (TD, WAIT, RUN, AUTO or STOP)"""
+        return self.query(":TRIG:STAT?").strip()
+
     def single(self) -> None:
         """Single acquisition"""
         self.write(":SING")
@@ -164,12 +169,12 @@ class RigolDHO954:
         self.write(":WAV:FORM ASC")
         self.write(f":WAV:POIN {points}")
 
-        preamble = self.query(":WAV:PRE?").split(',')
-        y_increment = float(preamble[7])
-        y_origin = float(preamble[8])
-        y_reference = float(preamble[9])
-        x_increment = float(preamble[4])
-        x_origin = float(preamble[5])
+        preamble = self.get_waveform_preamble()
+        y_increment = preamble['y_increment']
+        y_origin = preamble['y_origin']
+        y_reference = preamble['y_reference']
+        x_increment = preamble['x_increment']
+        x_origin = preamble['x_origin']
 
         self.write(":WAV:DATA?")
         raw_data = self.inst.read_raw()
@@ -186,6 +191,115 @@ class RigolDHO954:
         logger.debug(f"Retrieved {len(voltages)} data points from channel {channel}")
         return np.array(times), np.array(voltages)
 
+    def get_waveform_preamble(self) -> dict:
+        """
+        Read and parse the waveform preamble of the current :WAV:SOUR
+
+        Returns:
+            Dict with points, x_increment, x_origin, y_increment, y_origin and y_reference
+        """
+        preamble = self.query(":WAV:PRE?").split(',')
+        return {
+            'points': int(float(preamble[2])),
+            'x_increment': float(preamble[4]),
+            'x_origin': float(preamble[5]),
+            'y_increment': float(preamble[7]),
+            'y_origin': float(preamble[8]),
+            'y_reference': float(preamble[9]),
+        }
+
+    def get_waveform_raw(self, channel: int, points: int = 1000,
+                         data_format: str = 'WORD') -> tuple[dict, np.ndarray]:
+        """
+        Get the ADC codes of a channel in binary form
+
+        Args:
+            channel: Channel number (1-4)
+            points: Number of data points to retrieve
+            data_format: 'BYTE' (uint8 codes) or 'WORD' (uint16 codes)
+
+        Returns:
+            Tuple of (preamble dict, code array); volts are
+            (code - y_reference - y_origin) * y_increment
+        """
+        datatypes = {'BYTE': 'B', 'WORD': 'H'}
+        if data_format not in datatypes:
+            raise ValueError("Data format must be 'BYTE' or 'WORD'")
+        self.write(f":WAV:SOUR CHAN{channel}")
+        # Always the screen record, whatever window an earlier read left behind
+        self.write(":WAV:MODE NORM")
+        self.write(":WAV:STAR 1")
+        self.write(f":WAV:FORM {data_format}")
+        self.write(f":WAV:POIN {points}")
+        self.write(f":WAV:STOP {points}")
+        preamble = self.get_waveform_preamble()
+        codes = self.inst.query_binary_values(":WAV:DATA?", datatype=datatypes[data_format], is_big_endian=False,
+                                              container=np.array)
+        codes = codes.astype(np.uint8 if data_format == 'BYTE' else np.uint16, copy=False)
+        logger.debug(f"Retrieved {len(codes)} {data_format} codes from channel {channel}")
+        return preamble, codes
+
+    def read_waveform_chunks(self, channel: int, points: int = None,
+                             chunk_points: int = 100000) -> tuple[dict, Iterator[np.ndarray]]:
+        """
+        Read a deep-memory record in chunks of 16-bit samples
+
+        The record is transferred as consecutive :WAV:STAR/:WAV:STOP windows
+        of WORD data, so it is never held whole, neither as text nor as
+        float64. Stop the acquisition first so the record does not change
+        between chunks. :WAV:MODE, :WAV:STAR and :WAV:STOP are restored once
+        the preamble is read and again when the chunk iterator finishes or
+        is closed, so later reads see the normal screen window.
+
+        Args:
+            channel: Channel number (1-4)
+            points: Record length to read, or None for the whole memory depth
+            chunk_points: Samples per :WAV:DATA? transfer
+
+        Returns:
+            Tuple of (preamble, iterator of voltage arrays, one per chunk)
+        """
+        self.write(f":WAV:SOUR CHAN{channel}")
+        window = self.get_read_window()
+        try:
+            self.write(":WAV:MODE RAW")
+            self.write(":WAV:FORM WORD")
+            if points is not None:
+                self.write(f":WAV:POIN {points}")
+            preamble = self.get_waveform_preamble()
+        finally:
+            self.set_read_window(*window)
+        total = preamble['points'] if points is None else min(points, preamble['points'])
+
+        def chunks() -> Iterator[np.ndarray]:
+            self.write(f":WAV:SOUR CHAN{channel}")
+            self.write(":WAV:MODE RAW")
+            self.write(":WAV:FORM WORD")
+            try:
+                for start in range(1, total + 1, chunk_points):
+                    stop = min(start + chunk_points - 1, total)
+                    self.write(f":WAV:STAR {start}")
+                    self.write(f":WAV:STOP {stop}")
+                    raw = self.inst.query_binary_values(":WAV:DATA?", datatype='H', is_big_endian=False,
+                                                        container=np.array)
+                    yield (raw - preamble['y_reference'] - preamble['y_origin']) * preamble['y_increment']
+                logger.debug(f"Read {total} points from channel {channel} in chunks of {chunk_points}")
+            finally:
+                self.set_read_window(*window)
+
+        return preamble, chunks()
+
+    def get_read_window(self) -> tuple[str, int, int]:
+        """Current :WAV:MODE, :WAV:STAR and :WAV:STOP"""
+        return (self.query(":WAV:MODE?").strip(), int(float(self.query(":WAV:STAR?"))),
+                int(float(self.query(":WAV:STOP?"))))
+
+    def set_read_window(self, mode: str, start: int, stop: int) -> None:
+        """Set :WAV:MODE, :WAV:STAR and :WAV:STOP (e.g. as saved by get_read_window)"""
+        self.write(f":WAV:MODE {mode}")
+        self.write(f":WAV:STAR {start}")
+        self.write(f":WAV:STOP {stop}")
+
     def measure(self, measurement_type: str, channel: int) -> float:
         """
         Make automatic measurement
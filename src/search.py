@@ -0,0 +1,346 @@
+"""
+Post-capture search over acquired frames and recordings
+Glitch, pulse-width, runt, setup/hold and pattern searches, each a handful
+of array operations over edge indices, so rare events in deep records are
+found without a per-sample loop
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+from typing import Any, Dict, Iterable, List, Optional, Tuple
+
+import numpy as np
+
+from decoders import Annotation, Parameter, Threshold, get_logic_trace, pack_bus, parse_sources
+from edge_index import EdgeIndex
+from utils import format_time_value, parse_si_value
+
+logger = logging.getLogger(__name__)
+
+POLARITIES = ['Positive', 'Negative', 'Either']
+
+
+def find_pulses(trace: EdgeIndex, min_width: float, max_width: float, polarity: str = 'Either',
+                lane: str = '', kind: str = 'pulse', label: str = 'Pulse') -> List[Annotation]:
+    """
+    Find complete pulses whose width lies in [min_width, max_width]
+
+    Args:
+        trace: Logic trace
+        min_width: Shortest width in seconds
+        max_width: Longest width in seconds
+        polarity: 'Positive' (high pulses), 'Negative' or 'Either'
+        lane: Lane name put on the events
+        kind: Event kind
+        label: Text in front of the width
+
+    Returns:
+        One event per pulse
+    """
+    if polarity not in POLARITIES:
+        raise ValueError(f"Polarity must be one of {', '.join(POLARITIES)}")
+    edges = trace.edges
+    if len(edges) < 2:
+        return []
+    widths = np.diff(edges) * trace.dt
+    high = trace.edge_levels()[:-1] == 1
+    mask = (widths >= min_width) & (widths <= max_width)
+    if polarity == 'Positive':
+        mask &= high
+    elif polarity == 'Negative':
+        mask &= ~high
+    starts, ends = trace.times(edges[:-1][mask]), trace.times(edges[1:][mask])
+    return [Annotation(float(s), float(e), f"{label} {'+' if h else '-'}{format_time_value(w)}", lane, kind)
+            for s, e, w, h in zip(starts, ends, widths[mask], high[mask])]
+
+
+def find_glitches(trace: EdgeIndex, max_width: float, lane: str = '') -> List[Annotation]:
+    """Pulses of either polarity narrower than max_width"""
+    narrower = np.nextafter(max_width, 0)
+    return find_pulses(trace, 0.0, narrower, 'Either', lane, 'glitch', 'Glitch')
+
+
+def find_runts(time_data: np.ndarray, voltage: np.ndarray, low: float, high: float,
+               lane: str = '') -> List[Annotation]:
+    """
+    Find runt pulses: excursions across one threshold that turn back before the other
+
+    A positive runt rises above low and falls back below it without reaching
+    high; a negative runt dips below high and returns without reaching low.
+
+    Args:
+        time_data: Sample times in seconds (uniform)
+        voltage: Analog samples
+        low: Lower threshold in volts
+        high: Upper threshold in volts
+        lane: Lane name put on the events
+
+    Returns:
+        Runt events in time order
+    """
+    if high <= low:
+        raise ValueError("High threshold must be above the low threshold")
+    voltage = np.asarray(voltage)
+    above_low = EdgeIndex.from_samples(time_data, voltage > low)
+    above_high = EdgeIndex.from_samples(time_data, voltage > high)
+
+    def excursions(outer: EdgeIndex, inner: EdgeIndex, level: int) -> Tuple[np.ndarray, np.ndarray]:
+        """Pulses of outer at the given level during which inner never changes"""
+        edges = outer.edges
+        if len(edges) < 2:
+            return np.empty(0, dtype=np.int64), np.empty(0, dtype=np.int64)
+        pulse = outer.edge_levels()[:-1] == level
+        starts, ends = edges[:-1][pulse], edges[1:][pulse]
+        crossings = np.searchsorted(inner.edges, ends) - np.searchsorted(inner.edges, starts)
+        unchanged = (crossings == 0) & (inner.state_at_index(starts) == 1 - level)
+        return starts[unchanged], ends[unchanged]
+
+    events = []
+    for sign, (starts, ends) in (('+', excursions(above_low, above_high, 1)),
+                                 ('-', excursions(above_high, above_low, 0))):
+        width = (ends - starts) * above_low.dt
+        events.extend(Annotation(float(s), float(e), f"Runt {sign}{format_time_value(w)}", lane, 'runt')
+                      for s, e, w in zip(above_low.times(starts), above_low.times(ends), width))
+    events.sort(key=lambda a: a.start)
+    return events
+
+
+def find_setup_hold(clock: EdgeIndex, data: Dict[str, EdgeIndex], setup: float, hold: float,
+                    rising: bool = True) -> List[Annotation]:
+    """
+    Find data edges too close to the sampling clock edges
+
+    For every clock edge the nearest data edge at or before it (setup) and
+    after it (hold) are found with one binary search per data channel.
+
+    Args:
+        clock: Clock trace
+        data: Data traces keyed by lane name
+        setup: Required setup time in seconds
+        hold: Required hold time in seconds
+        rising: Sample on rising (True) or falling clock edges
+
+    Returns:
+        Violations in time order
+    """
+    dt = clock.dt
+    samples = clock.rising() if rising else clock.falling()
+    events = []
+    for lane, trace in data.items():
+        edges = trace.edges
+        if len(edges) == 0 or len(samples) == 0:
+            continue
+        after = np.searchsorted(edges, samples, side='right')
+        has_before, has_after = after > 0, after < len(edges)
+        before_edge = edges[np.maximum(after - 1, 0)]
+        after_edge = edges[np.minimum(after, len(edges) - 1)]
+        setup_gap = (samples - before_edge) * dt
+        hold_gap = (after_edge - samples) * dt
+
+        late = has_before & (setup_gap < setup)
+        events.extend(Annotation(float(s), float(e), f"Setup {format_time_value(g)}", lane, 'setup')
+                      for s, e, g in zip(clock.times(before_edge[late]), clock.times(samples[late]),
+                                         setup_gap[late]))
+        early = has_after & (hold_gap < hold)
+        events.extend(Annotation(float(s), float(e), f"Hold {format_time_value(g)}", lane, 'hold')
+                      for s, e, g in zip(clock.times(samples[early]), clock.times(after_edge[early]),
+                                         hold_gap[early]))
+    events.sort(key=lambda a: a.start)
+    return events
+
+
+def parse_pattern(pattern: str) -> Tuple[int, int]:
+    """
+    Parse a logic pattern written D15 first, e.g. 'XXXX XXXX 1010 0X01'
+
+    Args:
+        pattern: Up to 16 characters of 0, 1 or X; the last one is D0.
+            Spaces and underscores are ignored
+
+    Returns:
+        Tuple of (care mask, required value) with bit n for Dn
+    """
+    bits = pattern.replace(' ', '').replace('_', '').upper()
+    if not bits or len(bits) > 16 or set(bits) - set('01X'):
+        raise ValueError("Pattern must be up to 16 characters of 0, 1 or X (D15 first)")
+    mask = value = 0
+    for d, char in enumerate(reversed(bits)):
+        if char != 'X':
+            mask |= 1 << d
+            value |= int(char) << d
+    return mask, value
+
+
+def find_pattern(digital: Dict[int, EdgeIndex], pattern: str) -> List[Annotation]:
+    """
+    Find the intervals where the digital channels match a pattern
+
+    Only the channels that matter are packed (see decoders.pack_bus), so the
+    cost follows their edge count rather than the record length.
+
+    Args:
+        digital: Frame digital channels keyed by number
+        pattern: Pattern as accepted by parse_pattern
+
+    Returns:
+        One event per matching interval
+    """
+    mask, value = parse_pattern(pattern)
+    channels = [d for d in range(16) if mask >> d & 1]
+    if not channels:
+        raise ValueError("Pattern must contain at least one 0 or 1")
+    missing = [f"D{d}" for d in channels if d not in digital]
+    if missing:
+        raise ValueError(f"{', '.join(missing)} not in the captured frame")
+    reference = digital[channels[0]]
+    points, packed = pack_bus([digital[d] for d in channels])
+    match = packed == sum((value >> d & 1) << bit for bit, d in enumerate(channels))
+
+    # Merge consecutive matching segments
+    change = np.diff(np.concatenate([[False], match, [False]]).view(np.int8))
+    first, last = np.flatnonzero(change == 1), np.flatnonzero(change == -1)
+    ends = np.append(points, reference.length - 1)[last]
+    text = f"Pattern {pattern.strip()}"
+    return [Annotation(float(s), float(e), text, 'LA', 'pattern')
+            for s, e in zip(reference.times(points[first]), reference.times(ends))]
+
+
+class Search:
+    """Base class for post-capture searches"""
+
+    name = ''
+    parameters: List[Parameter] = []
+
+    def find(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """
+        Search a frame
+
+        Args:
+            frame: WaveformFrame to search
+            settings: Parameter values keyed by Parameter.key
+            threshold: Comparator level(s) for analog sources (see get_logic_trace)
+
+        Returns:
+            Events in time order
+        """
+        raise NotImplementedError
+
+
+class GlitchSearch(Search):
+    """Pulses narrower than a width"""
+
+    name = 'Glitch'
+    parameters = [
+        Parameter('source', 'Source', 'D0', channel=True),
+        Parameter('width', 'Narrower than', '20n', ['5n', '10n', '20n', '50n', '100n', '1u']),
+    ]
+
+    def find(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Find glitches on the source"""
+        trace = get_logic_trace(frame, settings['source'], threshold)
+        return find_glitches(trace, parse_si_value(settings['width']), settings['source'])
+
+
+class PulseWidthSearch(Search):
+    """Pulses with a width inside a range"""
+
+    name = 'Pulse width'
+    parameters = [
+        Parameter('source', 'Source', 'D0', channel=True),
+        Parameter('polarity', 'Polarity', 'Positive', POLARITIES),
+        Parameter('min_width', 'Min width', '1u', ['0', '100n', '1u', '10u', '100u']),
+        Parameter('max_width', 'Max width', '10u', ['100n', '1u', '10u', '100u', '1m']),
+    ]
+
+    def find(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Find pulses on the source within the width range"""
+        trace = get_logic_trace(frame, settings['source'], threshold)
+        return find_pulses(trace, parse_si_value(settings['min_width']), parse_si_value(settings['max_width']),
+                           settings['polarity'], settings['source'])
+
+
+class RuntSearch(Search):
+    """Analog pulses that cross one threshold but not the other"""
+
+    name = 'Runt'
+    parameters = [
+        Parameter('source', 'Source', 'CH1', ['CH1', 'CH2', 'CH3', 'CH4']),
+        Parameter('low', 'Low (V)', '0.8', ['0.4', '0.8', '1.0']),
+        Parameter('high', 'High (V)', '2.0', ['1.6', '2.0', '2.4']),
+    ]
+
+    def find(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Find runts on an analog channel"""
+        source = settings['source']
+        ch = int(source[2:])
+        if ch not in frame.analog:
+            raise ValueError(f"{source} is not in the captured frame")
+        time_data, voltage = frame.analog[ch]
+        return find_runts(time_data, voltage, parse_si_value(settings['low']), parse_si_value(settings['high']),
+                          source)
+
+
+class SetupHoldSearch(Search):
+    """Setup and hold violations of data channels against a clock"""
+
+    name = 'Setup/Hold'
+    parameters = [
+        Parameter('clock', 'Clock', 'D0', channel=True),
+        Parameter('edge', 'Edge', 'Rising', ['Rising', 'Falling']),
+        Parameter('data', 'Data', 'D1-D7', ['D1', 'D1-D7', 'D1-D15']),
+        Parameter('setup', 'Setup', '5n', ['1n', '2n', '5n', '10n', '20n']),
+        Parameter('hold', 'Hold', '2n', ['0', '1n', '2n', '5n', '10n']),
+    ]
+
+    def find(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Check every listed data channel against the clock"""
+        clock = get_logic_trace(frame, settings['clock'], threshold)
+        data = {source: get_logic_trace(frame, source, threshold) for source in parse_sources(settings['data'])}
+        return find_setup_hold(clock, data, parse_si_value(settings['setup']), parse_si_value(settings['hold']),
+                               settings['edge'] == 'Rising')
+
+
+class PatternSearch(Search):
+    """Intervals where D15-D0 match a 0/1/X pattern"""
+
+    name = 'Pattern'
+    parameters = [
+        Parameter('pattern', 'D15..D0', 'XXXX XXXX XXXX XX10', ['XXXX XXXX XXXX XX10']),
+    ]
+
+    def find(self, frame, settings: Dict[str, str], threshold: Threshold = 1.4) -> List[Annotation]:
+        """Match the pattern against the frame's digital channels"""
+        return find_pattern(frame.digital, settings['pattern'])
+
+
+SEARCHES: Dict[str, Search] = {
+    search.name: search for search in [GlitchSearch(), PulseWidthSearch(), RuntSearch(),
+                                       SetupHoldSearch(), PatternSearch()]
+}
+
+
+def search_frames(frames: Iterable, search: Search, settings: Dict[str, str],
+                  threshold: Threshold = 1.4, keys: Optional[Iterable] = None) -> List[Tuple[Any, Annotation]]:
+    """
+    Run a search over a sequence of frames, such as a loaded recording
+
+    Args:
+        frames: WaveformFrames to search
+        search: Search to run
+        settings: Parameter values of the search
+        threshold: Comparator level(s) for analog sources (see get_logic_trace)
+        keys: Tag of every frame, in frame order (e.g. its record in a capture
+            file); by default the frame sequence numbers
+
+    Returns:
+        (frame key, event) pairs in frame order
+    """
+    if keys is None:
+        pairs = ((frame, frame.sequence) for frame in frames)
+    else:
+        pairs = zip(frames, keys)
+    results = []
+    for frame, key in pairs:
+        results.extend((key, event) for event in search.find(frame, settings, threshold))
+    return results
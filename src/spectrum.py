@@ -0,0 +1,666 @@
+"""
+Real-time spectrum analysis for RIGOL DHO954 waveforms
+Windowed real-input FFTs with cached window coefficients and reused buffers
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+from typing import Dict, Optional, Tuple
+
+import numpy as np
+
+logger = logging.getLogger(__name__)
+
+# Cosine-sum window coefficients (periodic form, suited to spectral analysis)
+WINDOW_COEFFICIENTS = {
+    'Rectangular': (1.0,),
+    'Hann': (0.5, 0.5),
+    'Blackman': (0.42, 0.5, 0.08),
+    'Flat-top': (0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368),
+}
+
+# Half-width in bins (unpadded) of the leakage skirt that is credited to a
+# tone: the main lobe plus the sidelobes strong enough to bias noise figures
+LEAKAGE_HALF_WIDTH = {
+    'Rectangular': 3,
+    'Hann': 10,
+    'Blackman': 8,
+    'Flat-top': 6,
+}
+
+# numpy >= 2.0 can write FFT results into a preallocated array
+try:
+    np.fft.rfft(np.zeros(4), out=np.empty(3, dtype=np.complex128))
+    _RFFT_HAS_OUT = True
+except TypeError:
+    _RFFT_HAS_OUT = False
+
+
+def next_fast_len(n: int) -> int:
+    """
+    Smallest FFT length >= n whose only prime factors are 2, 3 and 5
+
+    Args:
+        n: Minimum length
+
+    Returns:
+        5-smooth length for which pocketfft is fast
+    """
+    if n <= 6:
+        return max(n, 1)
+    best = 1 << (n - 1).bit_length()
+    p5 = 1
+    while p5 < best:
+        p35 = p5
+        while p35 < best:
+            # Smallest power of two that brings p35 up to n
+            quotient = -(-n // p35)
+            candidate = p35 * (1 << (quotient - 1).bit_length())
+            best = min(best, candidate)
+            p35 *= 3
+        p5 *= 5
+    return best
+
+
+def make_window(name: str, n: int) -> np.ndarray:
+    """
+    Build a periodic cosine-sum window
+
+    Args:
+        name: Window name (key of WINDOW_COEFFICIENTS)
+        n: Window length
+
+    Returns:
+        Window coefficients as float64 array
+    """
+    if name not in WINDOW_COEFFICIENTS:
+        raise ValueError(f"Invalid window. Must be one of {list(WINDOW_COEFFICIENTS)}")
+    phase = 2.0 * np.pi * np.arange(n) / n
+    window = np.zeros(n)
+    for k, a in enumerate(WINDOW_COEFFICIENTS[name]):
+        window += (-1) ** k * a * np.cos(k * phase)
+    return window
+
+
+class SpectrumAnalyzer:
+    """Per-channel dBV magnitude spectra with cached windows and reused FFT buffers"""
+
+    def __init__(self, window: str = 'Hann'):
+        """
+        Initialize spectrum analyzer
+
+        Args:
+            window: Window name ('Rectangular', 'Hann', 'Blackman', 'Flat-top')
+        """
+        self.window = window
+        self._windows: Dict[Tuple[str, int], Tuple[np.ndarray, float]] = {}
+        self._freqs: Dict[Tuple[int, float], np.ndarray] = {}
+        self._buffers: Dict[int, dict] = {}
+        self.spectra: Dict[int, Tuple[np.ndarray, np.ndarray]] = {}
+
+    def set_window(self, window: str) -> None:
+        """Select the FFT window"""
+        if window not in WINDOW_COEFFICIENTS:
+            raise ValueError(f"Invalid window. Must be one of {list(WINDOW_COEFFICIENTS)}")
+        self.window = window
+
+    def get_window(self, n: int) -> Tuple[np.ndarray, float]:
+        """
+        Get cached window coefficients and their sum (coherent gain * n)
+
+        Args:
+            n: Window length
+
+        Returns:
+            Tuple of (window, window_sum)
+        """
+        key = (self.window, n)
+        if key not in self._windows:
+            window = make_window(self.window, n)
+            self._windows[key] = (window, float(window.sum()))
+        return self._windows[key]
+
+    def frequencies(self, nfft: int, sample_interval: float) -> np.ndarray:
+        """Cached bin center frequencies for an nfft-point real FFT"""
+        key = (nfft, sample_interval)
+        if key not in self._freqs:
+            self._freqs[key] = np.fft.rfftfreq(nfft, sample_interval)
+        return self._freqs[key]
+
+    def _channel_buffers(self, channel: int, n: int) -> dict:
+        """Get (re)allocated FFT buffers for a channel and input length"""
+        buffers = self._buffers.get(channel)
+        if buffers is None or buffers['n'] != n:
+            nfft = next_fast_len(n)
+            buffers = {
+                'n': n,
+                'nfft': nfft,
+                'input': np.zeros(nfft),  # Zero padding beyond n is never overwritten
+                'output': np.empty(nfft // 2 + 1, dtype=np.complex128),
+                'magnitude': np.empty(nfft // 2 + 1),
+            }
+            self._buffers[channel] = buffers
+        return buffers
+
+    def compute(self, channel: int, voltage: np.ndarray, sample_interval: float) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Compute the magnitude spectrum of one channel in dBV (dB re 1 Vrms)
+
+        The returned arrays are owned by the analyzer and overwritten by the
+        next call for the same channel.
+
+        Args:
+            channel: Channel number, selects the reused buffers
+            voltage: Sample voltages in volts
+            sample_interval: Time between samples in seconds
+
+        Returns:
+            Tuple of (frequencies_hz, magnitude_dbv)
+        """
+        n = len(voltage)
+        window, window_sum = self.get_window(n)
+        buffers = self._channel_buffers(channel, n)
+        nfft = buffers['nfft']
+
+        np.multiply(voltage, window, out=buffers['input'][:n])
+        if _RFFT_HAS_OUT:
+            spectrum = np.fft.rfft(buffers['input'], out=buffers['output'])
+        else:
+            spectrum = buffers['output']
+            spectrum[...] = np.fft.rfft(buffers['input'])
+
+        # Peak amplitude is 2|X|/sum(w); rms is that over sqrt(2)
+        magnitude = buffers['magnitude']
+        np.abs(spectrum, out=magnitude)
+        np.maximum(magnitude, 1e-20, out=magnitude)
+        np.log10(magnitude, out=magnitude)
+        magnitude *= 20.0
+        magnitude += 20.0 * np.log10(np.sqrt(2.0) / window_sum)
+        magnitude[0] -= 20.0 * np.log10(np.sqrt(2.0))  # DC has no conjugate bin and no rms factor
+
+        result = (self.frequencies(nfft, sample_interval), magnitude)
+        self.spectra[channel] = result
+        return result
+
+    def harmonics(self, channel: int, count: int = 10) -> Optional[Dict[str, float]]:
+        """
+        THD, SINAD, SNR and ENOB from the channel's last computed spectrum
+
+        Works on the complex FFT output that compute() left in the channel's
+        buffers, so it needs no extra transform. Power is summed over each
+        tone's leakage skirt (window dependent), so window leakage counts
+        towards the tone instead of the noise. Harmonics above Nyquist are
+        folded back to their alias frequency.
+
+        Args:
+            channel: Channel number
+            count: Highest harmonic included (2..count)
+
+        Returns:
+            Dict with freq (Hz), rms (V), thd (dB), thd_pct, sinad (dB),
+            snr (dB) and enob (bits); None if there is no usable spectrum
+        """
+        buffers = self._buffers.get(channel)
+        spectrum = self.spectra.get(channel)
+        if buffers is None or spectrum is None:
+            return None
+        n, nfft = buffers['n'], buffers['nfft']
+        if buffers.get('power_window') != self.window:
+            window, _ = self.get_window(n)
+            buffers['power'] = np.empty(len(buffers['output']))
+            buffers['used'] = np.empty(len(buffers['output']), dtype=bool)
+            buffers['power_window'] = self.window
+            buffers['window_power'] = float(np.dot(window, window))
+        power, used = buffers['power'], buffers['used']
+        np.abs(buffers['output'], out=power)
+        power **= 2
+        bins = len(power)
+
+        # Zero padding stretches the skirt by nfft/n bins
+        half = int(np.ceil(LEAKAGE_HALF_WIDTH[self.window] * nfft / n))
+        if bins <= 2 * half + 1:
+            return None
+        used.fill(False)
+        first = half + 1  # DC and its skirt are neither signal nor noise
+        used[:first] = True
+        total = power[first:].sum()
+
+        k0 = first + int(np.argmax(power[first:]))
+        half = max(1, min(half, (k0 - 1) // 2))  # Keep harmonic skirts apart at low frequencies
+        lo, hi = max(k0 - half, first), min(k0 + half + 1, bins)
+        lobe = power[lo:hi]
+        fundamental = lobe.sum()
+        if fundamental <= 0:
+            return None
+        used[lo:hi] = True
+        freqs = spectrum[0]
+        df = freqs[1]
+        f0 = float(np.dot(lobe, freqs[lo:hi]) / fundamental)
+
+        harmonic = 0.0
+        fs = nfft * df
+        for h in range(2, count + 1):
+            fh = (h * f0) % fs
+            if fh > fs / 2:
+                fh = fs - fh
+            kh = int(round(fh / df))
+            lo, hi = max(kh - half, 0), min(kh + half + 1, bins)
+            free = ~used[lo:hi]
+            harmonic += power[lo:hi][free].sum()
+            used[lo:hi] = True
+
+        noise = max(total - fundamental - harmonic, 1e-300)
+        harmonic = max(harmonic, 1e-300)
+        sinad = 10.0 * np.log10(fundamental / (noise + harmonic))
+        return {
+            'freq': f0,
+            # One-sided lobe power -> rms via Parseval
+            'rms': float(np.sqrt(2.0 * fundamental / (nfft * buffers['window_power']))),
+            'thd': float(10.0 * np.log10(harmonic / fundamental)),
+            'thd_pct': float(100.0 * np.sqrt(harmonic / fundamental)),
+            'sinad': float(sinad),
+            'snr': float(10.0 * np.log10(fundamental / noise)),
+            'enob': float((sinad - 1.76) / 6.02),
+        }
+
+    def process(self, frame) -> Dict[int, Tuple[np.ndarray, np.ndarray]]:
+        """
+        Compute spectra for every analog channel in a frame
+
+        Args:
+            frame: WaveformFrame to analyse
+
+        Returns:
+            Dict of channel -> (frequencies_hz, magnitude_dbv)
+        """
+        results = {}
+        for ch in frame.analog:
+            if frame.analog.length(ch) < 2:
+                continue
+            results[ch] = self.compute(ch, *frame.analog_samples(ch, np.float32))
+        return results
+
+
+AVERAGING_MODES = ['None', 'Linear', 'Exponential', 'Peak Hold']
+
+
+class SpectrumAverager:
+    """
+    Incremental per-channel spectrum averaging with O(bins) memory
+
+    Linear and exponential averages are taken on power (not dB). Linear
+    averaging is the running mean of the first N spectra and then continues
+    as an exponential average with weight 1/N, so it never needs to keep
+    past spectra. Peak hold keeps the per-bin maximum.
+    """
+
+    def __init__(self, mode: str = 'None', count: int = 16, alpha: float = 0.1):
+        """
+        Initialize spectrum averager
+
+        Args:
+            mode: One of AVERAGING_MODES
+            count: Number of spectra for linear averaging
+            alpha: Weight of the newest spectrum for exponential averaging (0-1]
+        """
+        self._state: Dict[int, dict] = {}
+        self.configure(mode, count, alpha)
+
+    def configure(self, mode: str, count: int, alpha: float) -> None:
+        """Change averaging parameters and restart all averages"""
+        if mode not in AVERAGING_MODES:
+            raise ValueError(f"Invalid averaging mode. Must be one of {AVERAGING_MODES}")
+        if count < 1:
+            raise ValueError("Average count must be at least 1")
+        if not 0 < alpha <= 1:
+            raise ValueError("Exponential weight must be in (0, 1]")
+        self.mode = mode
+        self.count = int(count)
+        self.alpha = float(alpha)
+        self.reset()
+
+    def reset(self) -> None:
+        """Restart averaging on every channel"""
+        self._state.clear()
+
+    def averages(self, channel: int) -> int:
+        """Number of spectra folded into a channel's current average"""
+        state = self._state.get(channel)
+        return state['n'] if state else 0
+
+    def update(self, channel: int, freqs: np.ndarray, magnitude_dbv: np.ndarray) -> np.ndarray:
+        """
+        Fold a new spectrum into a channel's average
+
+        The average restarts automatically whenever the bin layout (bin count
+        or spacing, i.e. points or timebase) changes.
+
+        Args:
+            channel: Channel number
+            freqs: Bin frequencies in Hz
+            magnitude_dbv: New spectrum in dBV
+
+        Returns:
+            Averaged spectrum in dBV (owned by the averager, updated in place)
+        """
+        if self.mode == 'None':
+            return magnitude_dbv
+
+        layout = (len(freqs), float(freqs[1] - freqs[0]) if len(freqs) > 1 else 0.0)
+        state = self._state.get(channel)
+        if state is None or state['layout'] != layout:
+            state = {
+                'layout': layout,
+                'n': 0,
+                'accumulator': np.empty_like(magnitude_dbv),
+                'scratch': np.empty_like(magnitude_dbv),
+                'output': np.empty_like(magnitude_dbv),
+            }
+            self._state[channel] = state
+
+        accumulator = state['accumulator']
+        output = state['output']
+        state['n'] += 1
+
+        if self.mode == 'Peak Hold':
+            # Max is order-preserving, so it is kept directly in dB
+            if state['n'] == 1:
+                accumulator[...] = magnitude_dbv
+            else:
+                np.maximum(accumulator, magnitude_dbv, out=accumulator)
+            output[...] = accumulator
+            return output
+
+        # dBV -> power (V^2)
+        power = state['scratch']
+        np.multiply(magnitude_dbv, np.log(10.0) / 10.0, out=power)
+        np.exp(power, out=power)
+
+        if state['n'] == 1:
+            accumulator[...] = power
+        else:
+            weight = 1.0 / min(state['n'], self.count) if self.mode == 'Linear' else self.alpha
+            power -= accumulator
+            power *= weight
+            accumulator += power
+
+        np.log10(accumulator, out=output)
+        output *= 10.0
+        return output
+
+
+class SpectrogramBuffer:
+    """
+    Preallocated ring buffer of the last K spectra for a waterfall display
+
+    Every spectrum is written twice, to rows i and i + K of a 2K-row array,
+    so the K newest spectra are always the contiguous slice [i + 1, i + K + 1)
+    in oldest-to-newest order. Scrolling therefore needs neither np.roll nor a
+    copy; the display hands that single view to its image artist.
+    """
+
+    def __init__(self, rows: int = 200, floor: float = -120.0):
+        """
+        Initialize spectrogram buffer
+
+        Args:
+            rows: Number of spectra kept (K)
+            floor: Value of rows not yet filled, in dBV
+        """
+        if rows < 1:
+            raise ValueError("Waterfall must keep at least one row")
+        self.rows = int(rows)
+        self.floor = floor
+        self.freqs: Optional[np.ndarray] = None
+        self._data = np.empty((0, 0), dtype=np.float32)
+        self._head = 0
+        self.count = 0
+
+    def reset(self, freqs: Optional[np.ndarray] = None) -> None:
+        """
+        Clear the history, optionally for a new bin layout
+
+        Args:
+            freqs: Bin frequencies of the spectra that will be pushed
+        """
+        if freqs is not None:
+            self.freqs = freqs
+            if self._data.shape != (2 * self.rows, len(freqs)):
+                self._data = np.empty((2 * self.rows, len(freqs)), dtype=np.float32)
+        self._data.fill(self.floor)
+        self._head = 0
+        self.count = 0
+
+    def push(self, freqs: np.ndarray, magnitude_dbv: np.ndarray) -> None:
+        """
+        Append a spectrum, restarting the history if the bin layout changed
+
+        Args:
+            freqs: Bin frequencies in Hz
+            magnitude_dbv: Spectrum in dBV
+        """
+        if (self.freqs is None or len(freqs) != len(self.freqs) or
+                (len(freqs) > 1 and freqs[1] != self.freqs[1])):
+            self.reset(freqs)
+        self._data[self._head] = magnitude_dbv
+        self._data[self._head + self.rows] = magnitude_dbv
+        self._head = (self._head + 1) % self.rows
+        self.count = min(self.count + 1, self.rows)
+
+    def view(self) -> np.ndarray:
+        """
+        The last K spectra, oldest first, as a view into the buffer
+
+        Returns:
+            float32 array of shape (K, bins); only valid until the next push
+        """
+        return self._data[self._head:self._head + self.rows]
+
+
+class ToneMonitor:
+    """
+    Amplitudes of a few chosen frequencies per channel (Goertzel bank)
+
+    Each tone is a single-bin DFT at an arbitrary frequency. Rather than
+    running the Goertzel recurrence sample by sample in Python, the record is
+    processed in blocks of BLOCK samples: the tone phasors and the window of
+    a block are cached for the first block only and rotated to every later
+    block by one complex factor per tone (and per window term), so every
+    frame costs O(N x tones) work while the cache stays O(BLOCK x tones),
+    however long the record is.
+    """
+
+    BLOCK = 1 << 16
+
+    def __init__(self, frequencies: Tuple[float, ...] = (), window: str = 'Hann'):
+        """
+        Initialize tone monitor
+
+        Args:
+            frequencies: Tone frequencies in Hz
+            window: Window name (key of WINDOW_COEFFICIENTS)
+        """
+        self._bank_key = None
+        self._bank: Optional[Tuple[np.ndarray, np.ndarray]] = None
+        self.results: Dict[int, np.ndarray] = {}
+        self.set_window(window)
+        self.set_frequencies(frequencies)
+
+    def set_frequencies(self, frequencies) -> None:
+        """Select the monitored tone frequencies in Hz"""
+        frequencies = np.asarray(frequencies, dtype=np.float64).ravel()
+        if (frequencies < 0).any():
+            raise ValueError("Tone frequencies must not be negative")
+        self.frequencies = frequencies
+        self._bank_key = None
+        self.results = {}
+
+    def set_window(self, window: str) -> None:
+        """Select the window applied before evaluating the tones"""
+        if window not in WINDOW_COEFFICIENTS:
+            raise ValueError(f"Invalid window. Must be one of {list(WINDOW_COEFFICIENTS)}")
+        self.window = window
+        self._bank_key = None
+
+    def _get_bank(self, n: int, sample_interval: float) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Phasors of the first block for a record layout
+
+        Returns:
+            Tuple of (tone phasors, tones x block; window term phasors,
+            terms x block, scaled by the signed cosine-sum coefficients)
+        """
+        block = min(n, self.BLOCK)
+        key = (self.window, n, sample_interval)
+        if key != self._bank_key:
+            index = np.arange(block)
+            tones = np.exp(-2j * np.pi * sample_interval * np.outer(self.frequencies, index))
+            coefficients = WINDOW_COEFFICIENTS[self.window]
+            terms = np.array([(-1) ** k * a for k, a in enumerate(coefficients)])
+            window_terms = terms[:, None] * np.exp(2j * np.pi * np.outer(np.arange(len(terms)), index) / n)
+            self._bank = (tones, window_terms)
+            self._bank_key = key
+        return self._bank
+
+    def measure(self, voltage: np.ndarray, sample_interval: float) -> np.ndarray:
+        """
+        Evaluate every tone on one record
+
+        Args:
+            voltage: Sample voltages in volts (float32 or float64)
+            sample_interval: Time between samples in seconds
+
+        Returns:
+            rms amplitude in volts per tone
+        """
+        if len(self.frequencies) == 0:
+            return np.empty(0)
+        n = len(voltage)
+        tones, window_terms = self._get_bank(n, sample_interval)
+        tone_step = -2.0 * np.pi * sample_interval * self.frequencies
+        window_step = 2.0 * np.pi * np.arange(len(window_terms)) / n
+        total = np.zeros(len(self.frequencies), dtype=np.complex128)
+        window_sum = 0.0
+        for start in range(0, n, self.BLOCK):
+            stop = min(start + self.BLOCK, n)
+            length = stop - start
+            window = (np.exp(1j * window_step * start) @ window_terms[:, :length]).real
+            window_sum += window.sum()
+            total += np.exp(1j * tone_step * start) * (tones[:, :length] @ (window * voltage[start:stop]))
+        # rms amplitude is sqrt(2)|X|/sum(w), except at DC
+        scale = np.where(self.frequencies == 0, 1.0, np.sqrt(2.0)) / window_sum
+        return np.abs(total) * scale
+
+    def process(self, frame) -> Dict[int, np.ndarray]:
+        """
+        Evaluate the tones on every analog channel in a frame
+
+        Args:
+            frame: WaveformFrame to analyse
+
+        Returns:
+            Dict of channel -> rms amplitude per tone
+        """
+        results = {}
+        for ch in frame.analog:
+            if frame.analog.length(ch) < 2:
+                continue
+            results[ch] = self.measure(*frame.analog_samples(ch, np.float32))
+        self.results = results
+        return results
+
+
+class StreamingWelch:
+    """
+    Welch power spectral density estimate built incrementally from chunks
+
+    Samples are copied into a single preallocated segment buffer; every time
+    it fills, the segment's mean is removed, it is windowed and its
+    periodogram is added to a running sum, and the overlap is slid to the
+    front. Memory is O(segment length) however long the record is, and chunks
+    can be fed while the rest of the record is still being transferred.
+    """
+
+    def __init__(self, segment_length: int = 65536, overlap: float = 0.5, window: str = 'Hann'):
+        """
+        Initialize streaming Welch estimator
+
+        Args:
+            segment_length: Samples per segment (sets the resolution: fs / segment_length)
+            overlap: Fraction of a segment shared with the next one [0, 1)
+            window: Window name (key of WINDOW_COEFFICIENTS)
+        """
+        if segment_length < 2:
+            raise ValueError("Segment length must be at least 2")
+        if not 0 <= overlap < 1:
+            raise ValueError("Overlap must be in [0, 1)")
+        self.segment_length = int(segment_length)
+        self.hop = max(1, int(round(self.segment_length * (1 - overlap))))
+        self.window = make_window(window, self.segment_length)
+        self._window_power = float(np.dot(self.window, self.window))
+        self._segment = np.empty(self.segment_length)
+        self._windowed = np.empty(self.segment_length)
+        self._spectrum = np.empty(self.segment_length // 2 + 1, dtype=np.complex128)
+        self._power = np.empty(self.segment_length // 2 + 1)
+        self._sum = np.zeros(self.segment_length // 2 + 1)
+        self.reset()
+
+    def reset(self) -> None:
+        """Discard all accumulated segments"""
+        self._fill = 0
+        self._sum.fill(0.0)
+        self.segments = 0
+        self.samples = 0
+
+    def feed(self, chunk: np.ndarray) -> None:
+        """
+        Consume the next chunk of the record
+
+        Args:
+            chunk: Consecutive samples in volts (any length)
+        """
+        n = len(chunk)
+        pos = 0
+        while pos < n:
+            take = min(self.segment_length - self._fill, n - pos)
+            self._segment[self._fill:self._fill + take] = chunk[pos:pos + take]
+            self._fill += take
+            pos += take
+            if self._fill == self.segment_length:
+                self._accumulate()
+                keep = self.segment_length - self.hop
+                self._segment[:keep] = self._segment[self.hop:].copy()
+                self._fill = keep
+        self.samples += n
+
+    def _accumulate(self) -> None:
+        """Add the periodogram of the full segment buffer to the running sum"""
+        np.subtract(self._segment, self._segment.mean(), out=self._windowed)
+        self._windowed *= self.window
+        if _RFFT_HAS_OUT:
+            np.fft.rfft(self._windowed, out=self._spectrum)
+        else:
+            self._spectrum[...] = np.fft.rfft(self._windowed)
+        np.abs(self._spectrum, out=self._power)
+        self._power **= 2
+        self._sum += self._power
+        self.segments += 1
+
+    def psd(self, sample_interval: float) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        One-sided power spectral density of the segments fed so far
+
+        Args:
+            sample_interval: Time between samples in seconds
+
+        Returns:
+            Tuple of (frequencies_hz, psd_v2_per_hz)
+        """
+        if self.segments == 0:
+            raise ValueError(f"Need at least {self.segment_length} samples for one segment")
+        psd = self._sum * (2.0 * sample_interval / (self._window_power * self.segments))
+        psd[0] /= 2.0  # DC and Nyquist have no mirrored negative-frequency bin
+        if self.segment_length % 2 == 0:
+            psd[-1] /= 2.0
+        return np.fft.rfftfreq(self.segment_length, sample_interval), psd
@@ -33,13 +33,19 @@ def test_utils():
     print("Testing utilities...")
     from utils import (format_measurement_value, validate_scale_value, validate_channel_number,
                       validate_digital_channel, validate_digital_threshold, validate_digital_label,
-                      is_valid_threshold_type, get_threshold_voltage)
+                      is_valid_threshold_type, get_threshold_voltage, parse_si_value)
 
     # Test measurement formatting
     assert format_measurement_value(1000.0, 'FREQ') == "1.000 kHz"
     assert format_measurement_value(0.001, 'VPP') == "1.000 mV"
     assert format_measurement_value(0.000001, 'PER') == "1.000 µs"
 
+    # Test SI value parsing
+    assert abs(parse_si_value('20n') - 20e-9) < 1e-18
+    assert abs(parse_si_value('1.5 µs') - 1.5e-6) < 1e-15
+    assert parse_si_value('2.4V') == 2.4
+    assert parse_si_value('10 MHz') == 10e6
+
     # Test analog channel validation
     assert validate_scale_value(0.001) == True
     assert validate_scale_value(1000) == True
@@ -85,6 +91,1438 @@ def test_utils():
 
     print("✓ Utility tests passed (including logic analyzer functions)")
 
+def test_persistence():
+    """Test persistence histogram accumulation and decay"""
+    print("Testing persistence...")
+    import numpy as np
+    from persistence import PersistenceHistogram
+
+    hist = PersistenceHistogram(time_bins=100, voltage_bins=50)
+    t = np.linspace(0, 1e-3, 1000)
+    v = np.sin(2 * np.pi * 1e3 * t)
+
+    # Every in-range sample lands in exactly one bin
+    hist.accumulate(t, v, (-2.0, 2.0), now=0.0)
+    assert hist.counts.sum() == 1000
+    hist.accumulate(t, v * 10, (-2.0, 2.0), now=0.0)  # Mostly off-screen
+    assert 1000 < hist.counts.sum() < 2000
+
+    # Changing the voltage window restarts accumulation
+    hist.accumulate(t, v, (-1.5, 1.5), now=0.0)
+    assert hist.counts.sum() == 1000 and hist.frames == 1
+
+    # Hits fade below 5% after the decay time
+    hist.set_decay(1.0)
+    hist.accumulate(t, v, (-1.5, 1.5), now=10.0)
+    hist.accumulate(t[:1], v[:1], (-1.5, 1.5), now=11.0)  # Too short to add hits
+    hist.accumulate(t, v * 0, (-1.5, 1.5), now=11.0)
+    assert hist.counts.sum() < 1000 + 0.05 * 1000
+
+    intensity = hist.intensity()
+    assert intensity.shape == (50, 100)
+    assert 0.0 <= intensity.min() and intensity.max() == 1.0
+
+    print("✓ Persistence tests passed")
+
+def test_headless_renderer():
+    """Test offscreen frame-sequence rendering"""
+    print("Testing headless renderer...")
+    import subprocess
+    import tempfile
+    import numpy as np
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from headless_renderer import HeadlessRenderer
+
+    # The renderer must not pull in Tk
+    here = os.path.dirname(os.path.abspath(__file__))
+    subprocess.run([sys.executable, "-c",
+                    "import sys, headless_renderer; assert 'tkinter' not in sys.modules"],
+                   cwd=here, check=True)
+
+    t = np.linspace(0, 1e-3, 500)
+    frames = [WaveformFrame(timestamp=i * 0.1, sequence=i,
+                            analog={1: (t, np.sin(2 * np.pi * 1e3 * t + i))},
+                            digital={0: EdgeIndex.from_samples(t, t > 5e-4)})
+              for i in range(20)]
+
+    renderer = HeadlessRenderer(figsize=(4, 3), dpi=50)
+    with tempfile.TemporaryDirectory() as out:
+        written = renderer.export_sequence(frames, out, fps=2.0)  # 2 s of stream at 2 fps
+        assert len(written) == 4
+        with open(written[0], 'rb') as f:
+            assert f.read(8) == b'\x89PNG\r\n\x1a\n'
+
+    print("✓ Headless renderer tests passed")
+
+def test_acquisition_pipeline():
+    """Test that stages see every frame while the display sees only the newest"""
+    print("Testing acquisition pipeline...")
+    from acquisition import AcquisitionPipeline, WaveformFrame
+
+    pipeline = AcquisitionPipeline()
+    seen = []
+    pipeline.add_stage(lambda frame: seen.append(frame.sequence))
+    pipeline.add_stage(lambda frame: 1 / 0)  # A failing stage must not stop the others
+
+    assert pipeline.take_latest() is None
+    for i in range(10):
+        pipeline.submit(WaveformFrame(timestamp=float(i), sequence=i))
+
+    assert seen == list(range(10))
+    assert pipeline.take_latest().sequence == 9
+    assert pipeline.take_latest() is None  # Already displayed
+    assert pipeline.latest.sequence == 9
+    assert pipeline.frames_acquired == 10
+
+    print("✓ Acquisition pipeline tests passed")
+
+def test_raster_view():
+    """Test raster live view rendering and native/numpy rasterizer agreement"""
+    print("Testing raster view...")
+    import numpy as np
+    import raster_view
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+
+    rng = np.random.default_rng(0)
+    for steps in (False, True):
+        image = np.zeros((60, 80, 3), dtype=np.uint8)
+        x = np.sort(rng.uniform(-5, 85, 300))
+        y = rng.uniform(12, 70, 300)
+        raster_view.draw_trace_numpy(image, x, y, (255, 0, 0), 10, 50, steps)
+        rows = np.flatnonzero(image[..., 0].any(axis=1))
+        assert rows.min() >= 10 and rows.max() < 50  # Clipped to the row band
+        assert image[10:50, :, 0].any(axis=0).sum() > 70  # Columns are joined up
+        if raster_view._rasterizer is not None:
+            native = np.zeros_like(image)
+            raster_view._rasterizer.draw_trace(native, x, y, (255, 0, 0), 10, 50, steps)
+            assert np.array_equal(native, image)
+
+    # Repeated x and infinite or huge rows (overrange, sentinel values) are clipped, not cast
+    x = np.array([0.0, 10.0, 10.0, 30.0])
+    y = np.array([np.inf, -np.inf, 1e300, 5.0])
+    for steps in (False, True):
+        image = np.zeros((60, 80, 3), dtype=np.uint8)
+        raster_view.draw_trace_numpy(image, x, y, (255, 0, 0), 10, 50, steps)
+        assert not image[:10].any() and not image[50:].any()
+        if raster_view._rasterizer is not None:
+            native = np.zeros_like(image)
+            raster_view._rasterizer.draw_trace(native, x, y, (255, 0, 0), 10, 50, steps)
+            assert np.array_equal(native, image)
+
+    t = np.linspace(0, 1e-3, 2000)
+    frame = WaveformFrame(timestamp=0.0, analog={1: (t, np.sin(2 * np.pi * 2e3 * t))},
+                          digital={3: EdgeIndex.from_samples(t, t > 5e-4)})
+    canvas = raster_view.RasterCanvas(200, 100)
+    image = canvas.render(frame, {1: (-2.0, 2.0)})
+    assert image.shape == (100, 200, 3)
+    assert (image == canvas.analog_colors[1]).all(axis=-1).any()
+    assert (image == canvas.digital_colors[3]).all(axis=-1).any()
+    assert canvas.to_ppm().startswith(b"P6 200 100 255 ")
+
+    print("✓ Raster view tests passed")
+
+def test_spectrum():
+    """Test FFT sizing, dBV scaling, buffer reuse and the spectrum pane layout"""
+    print("Testing spectrum...")
+    import numpy as np
+    from spectrum import SpectrumAnalyzer, next_fast_len
+    from waveform_figure import create_waveform_figure, create_spectrum_axes, set_spectrum_visible
+
+    assert next_fast_len(1000) == 1000
+    assert next_fast_len(10007) == 10125  # 3^4 * 5^3
+    assert next_fast_len(1025) == 1080
+
+    # 1 V peak sine (-3.01 dBV) plus 0.5 V DC (-6.02 dBV), bin-centered
+    t = np.arange(10000) * 1e-6
+    v = np.sin(2 * np.pi * 1e3 * t) + 0.5
+    for window in ('Hann', 'Blackman', 'Flat-top'):
+        analyzer = SpectrumAnalyzer(window)
+        freqs, dbv = analyzer.compute(1, v, 1e-6)
+        peak = np.argmax(dbv[1:]) + 1
+        assert freqs[peak] == 1e3
+        assert abs(dbv[peak] - 20 * np.log10(1 / np.sqrt(2))) < 0.01
+        assert abs(dbv[0] - 20 * np.log10(0.5)) < 0.01
+
+    # Buffers are reused from frame to frame
+    _, again = analyzer.compute(1, v, 1e-6)
+    assert again is dbv
+
+    fig, ax, ax_digital = create_waveform_figure()
+    ax_fft = create_spectrum_axes(fig)
+    set_spectrum_visible(fig, ax, ax_digital, ax_fft, True)
+    assert ax_fft.get_visible() and ax_fft.get_position().y1 < ax_digital.get_position().y0
+    set_spectrum_visible(fig, ax, ax_digital, ax_fft, False)
+    assert not ax_fft.get_visible()
+
+    print("✓ Spectrum tests passed")
+
+def test_spectrum_averaging():
+    """Test power-domain linear, exponential and peak-hold spectrum averaging"""
+    print("Testing spectrum averaging...")
+    import numpy as np
+    from spectrum import SpectrumAverager
+
+    freqs = np.arange(8.0)
+    to_dbv = lambda p: np.full(8, 10 * np.log10(p))
+
+    # Running mean of the first N, then weight 1/N
+    averager = SpectrumAverager('Linear', count=4)
+    for p in (1.0, 2.0, 3.0, 4.0):
+        avg = averager.update(1, freqs, to_dbv(p))
+    assert np.allclose(10 ** (avg / 10), 2.5)
+    again = averager.update(1, freqs, to_dbv(6.5))
+    assert again is avg and np.allclose(10 ** (avg / 10), 3.5)
+
+    averager.configure('Exponential', 4, 0.5)
+    averager.update(1, freqs, to_dbv(1.0))
+    avg = averager.update(1, freqs, to_dbv(3.0))
+    assert np.allclose(10 ** (avg / 10), 2.0)
+
+    averager.configure('Peak Hold', 4, 0.5)
+    averager.update(1, freqs, np.array([0, -10, 0, -10, 0, -10, 0, -10.0]))
+    avg = averager.update(1, freqs, np.array([-10, 0, -10, 0, -10, 0, -10, 0.0]))
+    assert (avg == 0).all() and averager.averages(1) == 2
+
+    # A new bin layout restarts the average
+    averager.update(1, np.arange(8.0) * 2, np.full(8, -20.0))
+    assert averager.averages(1) == 1
+
+    print("✓ Spectrum averaging tests passed")
+
+def test_spectrogram_buffer():
+    """Test the double-write waterfall ring buffer and waterfall layout"""
+    print("Testing spectrogram buffer...")
+    import warnings
+    import numpy as np
+    from spectrum import SpectrogramBuffer
+    from waveform_figure import (create_waveform_figure, create_spectrum_axes, create_waterfall_axes,
+                                 set_spectrum_visible)
+
+    freqs = np.arange(4.0)
+    buffer = SpectrogramBuffer(rows=3)
+    buffer.push(freqs, np.zeros(4))
+    data = buffer._data
+    for i in range(1, 7):
+        buffer.push(freqs, np.full(4, float(i)))
+        view = buffer.view()
+        assert view.base is data and view.shape == (3, 4)
+    # Oldest first, newest last
+    assert np.array_equal(buffer.view()[:, 0], [4.0, 5.0, 6.0])
+    assert buffer._data is data  # No reallocation while scrolling
+
+    # Partially filled history is padded with the floor value
+    buffer.reset()
+    buffer.push(freqs, np.zeros(4))
+    assert np.array_equal(buffer.view()[:, 0], [-120.0, -120.0, 0.0])
+
+    # A new bin layout restarts the history
+    buffer.push(np.arange(6.0), np.ones(6))
+    assert buffer.view().shape == (3, 6) and buffer.count == 1
+
+    fig, ax, ax_digital = create_waveform_figure()
+    ax_fft = create_spectrum_axes(fig)
+    ax_waterfall, image = create_waterfall_axes(fig, 3)
+    set_spectrum_visible(fig, ax, ax_digital, ax_fft, True, ax_waterfall, True)
+    assert ax_waterfall.get_visible()
+    assert ax_waterfall.get_position().y1 < ax_fft.get_position().y0
+    # Every layout is applied by tight_layout, not skipped with a warning
+    with warnings.catch_warnings():
+        warnings.simplefilter('error')
+        for visible, waterfall in [(True, False), (False, False), (True, True), (False, True)]:
+            set_spectrum_visible(fig, ax, ax_digital, ax_fft, visible, ax_waterfall, waterfall)
+    assert not ax_waterfall.get_visible() and not ax_fft.get_visible()
+    assert ax_digital.get_position().y0 < 0.2  # The time-domain rows fill the figure again
+
+    print("✓ Spectrogram buffer tests passed")
+
+def test_tone_monitor():
+    """Test Goertzel-bank tone amplitudes and the trend log"""
+    print("Testing tone monitor...")
+    import csv
+    import tempfile
+    import numpy as np
+    from acquisition import WaveformFrame
+    from spectrum import ToneMonitor
+    from trend import TrendLogger
+
+    # 1 Vpk at 50 Hz, 0.1 Vpk at 150 Hz, 0.25 V DC; 10 full cycles of 50 Hz
+    t = np.arange(20000) * 1e-5
+    v = np.sin(2 * np.pi * 50 * t) + 0.1 * np.sin(2 * np.pi * 150 * t + 0.3) + 0.25
+    monitor = ToneMonitor([50.0, 100.0, 150.0, 0.0], window='Hann')
+    rms = monitor.measure(v, 1e-5)
+    assert np.allclose(rms, [1 / np.sqrt(2), 0.0, 0.1 / np.sqrt(2), 0.25], atol=1e-6)
+
+    # Off-bin tone with a flat-top window stays within 0.1 dB
+    monitor.set_window('Flat-top')
+    monitor.set_frequencies([57.3])
+    rms = monitor.measure(np.sin(2 * np.pi * 57.3 * t), 1e-5)
+    assert abs(20 * np.log10(rms[0] * np.sqrt(2))) < 0.1
+
+    # Records longer than one block: rotated block phasors match a direct windowed DFT
+    from spectrum import make_window
+    n = 3 * ToneMonitor.BLOCK + 1234
+    long_t = np.arange(n) * 1e-6
+    long_v = 0.5 * np.sin(2 * np.pi * 1234.5 * long_t) + 0.02 * np.cos(2 * np.pi * 20000 * long_t)
+    monitor.set_window('Hann')
+    monitor.set_frequencies([1234.5, 20000.0, 777.0])
+    window = make_window('Hann', n)
+    direct = [np.sqrt(2) * abs(np.sum(window * long_v * np.exp(-2j * np.pi * f * long_t))) / window.sum()
+              for f in monitor.frequencies]
+    assert np.allclose(monitor.measure(long_v, 1e-6), direct, rtol=1e-9, atol=1e-12)
+    assert np.allclose(monitor.measure(long_v.astype(np.float32), 1e-6), direct, atol=1e-6)
+    tones, window_terms = monitor._get_bank(n, 1e-6)
+    assert tones.shape == (3, ToneMonitor.BLOCK) and window_terms.shape[1] == ToneMonitor.BLOCK
+
+    monitor.set_window('Flat-top')
+    monitor.set_frequencies([57.3])
+    frame = WaveformFrame(timestamp=0.0, analog={1: (t, v), 2: (t, 2 * v)})
+    results = monitor.process(frame)
+    assert set(results) == {1, 2} and np.isclose(results[2][0], 2 * results[1][0])
+
+    with tempfile.TemporaryDirectory() as tmp:
+        filename = f"{tmp}/trend.csv"
+        trend = TrendLogger(filename)
+        trend.log(1.0, {'CH1_50Hz': 0.5, 'CH2_50Hz': 0.25})
+        trend.log(2.0, {'CH1_50Hz': 0.75})
+        trend.log(3.0, {'CH1_50Hz': 0.5, 'CH3_50Hz': 0.125})  # CH3 enabled while logging
+        trend.close()
+        with open(filename) as f:
+            rows = list(csv.reader(f))
+        assert rows[0] == ['Timestamp', 'CH1_50Hz', 'CH2_50Hz']
+        assert rows[1][1:] == ['0.5', '0.25'] and rows[2][1:] == ['0.75', ''] and len(rows) == 3
+        assert trend.files == [filename, f"{tmp}/trend_1.csv"] and trend.rows == 3
+        with open(trend.files[1]) as f:
+            rows = list(csv.reader(f))
+        assert rows[0] == ['Timestamp', 'CH1_50Hz', 'CH3_50Hz'] and rows[1][1:] == ['0.5', '0.125']
+
+    print("✓ Tone monitor tests passed")
+
+def test_streaming_welch():
+    """Test chunked Welch PSD against a whole-record reference and chunk prefetching"""
+    print("Testing streaming Welch PSD...")
+    import numpy as np
+    from acquisition import prefetch
+    from spectrum import StreamingWelch, make_window
+
+    rng = np.random.default_rng(1)
+    record = rng.normal(0.0, 0.1, 50000) + 0.5 * np.sin(2 * np.pi * 0.05 * np.arange(50000))
+    dt = 1e-6
+
+    # Reference: all overlapped segments of the whole record at once
+    length, hop = 1024, 512
+    window = make_window('Hann', length)
+    starts = np.arange(0, len(record) - length + 1, hop)
+    segments = np.stack([record[s:s + length] for s in starts])
+    segments -= segments.mean(axis=1, keepdims=True)
+    power = np.abs(np.fft.rfft(segments * window, axis=1)) ** 2
+    reference = power.mean(axis=0) * 2 * dt / np.dot(window, window)
+    reference[0] /= 2
+    reference[-1] /= 2
+
+    # Same result whatever the chunking
+    for chunk in (7, 1000, 50000):
+        welch = StreamingWelch(length, 0.5, 'Hann')
+        for start in range(0, len(record), chunk):
+            welch.feed(record[start:start + chunk])
+        freqs, psd = welch.psd(dt)
+        assert welch.segments == len(starts)
+        assert np.allclose(psd, reference)
+    assert freqs[1] == 1 / (length * dt)
+
+    # White noise: PSD integrates to its variance
+    welch = StreamingWelch(4096, 0.5, 'Hann')
+    welch.feed(rng.normal(0.0, 0.2, 400000))
+    _, psd = welch.psd(dt)
+    assert abs(psd.sum() / (4096 * dt) - 0.04) < 0.002
+
+    # Prefetching keeps order and forwards producer errors
+    assert list(prefetch(iter(range(10)))) == list(range(10))
+
+    def failing():
+        yield 1
+        raise IOError("transfer aborted")
+
+    try:
+        list(prefetch(failing()))
+        assert False, "producer error was not raised"
+    except IOError:
+        pass
+
+    print("✓ Streaming Welch tests passed")
+
+def test_harmonic_analysis():
+    """Test THD, SINAD, SNR and ENOB from the reused FFT buffers"""
+    print("Testing harmonic analysis...")
+    import numpy as np
+    from spectrum import SpectrumAnalyzer
+    from utils import format_measurement_value
+
+    # Off-bin 1 Vpk fundamental, -40 dB 2nd and -60 dB 3rd harmonic, 1 mV rms noise
+    rng = np.random.default_rng(0)
+    t = np.arange(10000) * 1e-6
+    f0 = 12345.6
+    v = (np.sin(2 * np.pi * f0 * t) + 0.01 * np.sin(2 * np.pi * 2 * f0 * t)
+         + 0.001 * np.sin(2 * np.pi * 3 * f0 * t) + rng.normal(0, 1e-3, len(t)))
+    expected_snr = 10 * np.log10(0.5 / 1e-6)
+    for window in ('Hann', 'Blackman', 'Flat-top'):
+        analyzer = SpectrumAnalyzer(window)
+        analyzer.compute(1, v, 1e-6)
+        result = analyzer.harmonics(1, count=5)
+        assert abs(result['freq'] - f0) < 1.0
+        assert abs(result['rms'] - 1 / np.sqrt(2)) < 1e-3
+        assert abs(result['thd'] - 10 * np.log10(1e-4 + 1e-6)) < 0.1
+        assert abs(result['thd_pct'] - 100 * np.sqrt(1e-4 + 1e-6)) < 0.01
+        assert abs(result['snr'] - expected_snr) < 1.0
+        assert abs(result['enob'] - (result['sinad'] - 1.76) / 6.02) < 1e-9
+
+    # 8-bit quantized sine: ENOB close to 8
+    q = np.round(np.sin(2 * np.pi * f0 * t) * 127.5) / 127.5
+    analyzer.compute(2, q, 1e-6)
+    assert 7.5 < analyzer.harmonics(2)['enob'] < 8.5
+
+    assert analyzer.harmonics(3) is None
+    assert format_measurement_value(-40.0, 'THD') == "-40.00 dB"
+    assert format_measurement_value(7.9, 'ENOB') == "7.90 bits"
+
+    print("✓ Harmonic analysis tests passed")
+
+def test_edge_index():
+    """Test the run-length digital storage: round trip, lookups, range queries and memory"""
+    print("Testing edge index...")
+    import tempfile
+    import numpy as np
+    from acquisition import load_csv_frame
+    from edge_index import EdgeIndex
+
+    rng = np.random.default_rng(0)
+    for initial in (0, 1):
+        levels = (np.cumsum(rng.random(5000) < 0.05) + initial) % 2
+        edges = EdgeIndex.from_levels(levels, t0=-1e-3, dt=1e-6)
+        assert edges.initial == initial and len(edges) == 5000
+        assert np.array_equal(edges.to_levels(), levels)
+        assert np.array_equal(edges.to_levels(1234, 2345), levels[1234:2345])
+        probes = rng.integers(0, 5000, 100)
+        assert np.array_equal(edges.state_at_index(probes), levels[probes])
+        assert np.array_equal(edges.state_at(-1e-3 + probes * 1e-6), levels[probes])
+        assert np.array_equal(edges.rising(), np.flatnonzero(np.diff(levels) == 1) + 1)
+        assert np.array_equal(edges.falling(), np.flatnonzero(np.diff(levels) == -1) + 1)
+        assert np.array_equal(edges.inverted().to_levels(), 1 - levels)
+        inside = edges.edges_in(1000, 2000)
+        assert np.all((inside >= 1000) & (inside < 2000))
+
+        # Step-trace corners for a zoomed view reproduce the levels inside it
+        t, y = edges.step_points((-1e-3 + 1000e-6, -1e-3 + 2000e-6))
+        assert t[0] == edges.times(1000) and t[-1] == edges.times(2000)
+        assert np.array_equal(y, levels[np.rint((t + 1e-3) / 1e-6).astype(int)])
+
+    # A slow clock in a deep record costs a few edges instead of 16 bytes per sample
+    n = 10_000_000
+    clock = (np.arange(n) // 50_000) % 2
+    edges = EdgeIndex.from_samples(np.arange(n) * 1e-9, clock)
+    dense = n * (8 + 8)
+    assert dense / edges.nbytes >= 100, f"only {dense / edges.nbytes:.0f}x smaller"
+    assert edges.state_at_index(n - 1) == clock[-1]
+
+    # CSV-loaded frames come in as edge indices
+    with tempfile.TemporaryDirectory() as tmp:
+        with open(f"{tmp}/frame.csv", 'w') as f:
+            f.write("Time,CH1,D2\n0.0,0.5,0\n1e-6,0.6,1\n2e-6,0.7,1\n3e-6,0.8,0\n")
+        frame = load_csv_frame(f"{tmp}/frame.csv")
+        assert isinstance(frame.digital[2], EdgeIndex)
+        assert np.array_equal(frame.digital[2].to_levels(), [0, 1, 1, 0])
+
+    print("✓ Edge index tests passed")
+
+def make_uart_trace(data, baud, sample_rate, data_bits=8, parity='None', stop_bits=1):
+    """Synthesize an idle-high UART logic trace (test helper)"""
+    import numpy as np
+    bits = [1, 1]
+    for value in data:
+        word = [0] + [(value >> i) & 1 for i in range(data_bits)]
+        if parity != 'None':
+            word.append(sum(word[1:]) % 2 if parity == 'Even' else 1 - sum(word[1:]) % 2)
+        bits += word + [1] * stop_bits
+    bits += [1, 1]
+    samples_per_bit = sample_rate / baud
+    n = int(len(bits) * samples_per_bit)
+    levels = np.array(bits, dtype=np.int64)[(np.arange(n) / samples_per_bit).astype(int)]
+    return np.arange(n) / sample_rate - 1e-4, levels
+
+def test_uart_decoder():
+    """Test vectorized UART decoding from digital and thresholded analog channels"""
+    print("Testing UART decoder...")
+    import time
+    import numpy as np
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from decoders import DECODERS, decode_uart
+    from waveform_figure import create_waveform_figure, draw_annotations
+
+    t, levels = make_uart_trace(b"Hello, world!", 115200, 10e6, parity='Even', stop_bits=2)
+    frame = WaveformFrame(timestamp=0.0, digital={3: EdgeIndex.from_samples(t, levels)}, analog={2: (t, levels * 3.3)})
+    settings = {'rx': 'D3', 'baud': '115200', 'data_bits': '8', 'parity': 'Even', 'stop_bits': '2', 'idle': 'High'}
+    annotations = DECODERS['UART'].decode(frame, settings)
+    assert bytes(a.value for a in annotations) == b"Hello, world!"
+    assert all(a.kind == 'data' and a.lane == 'D3' for a in annotations)
+    assert annotations[0].text == "0x48 'H'"
+    assert abs((annotations[0].end - annotations[0].start) - 12 / 115200) < 1e-9
+
+    # Analog source; the wrong parity setting flags every word
+    settings.update(rx='CH2', parity='Odd')
+    annotations = DECODERS['UART'].decode(frame, settings, threshold=1.65)
+    assert len(annotations) == 13 and all(a.kind == 'error' for a in annotations)
+
+    # Inverted line
+    assert [a.value for a in decode_uart(EdgeIndex.from_samples(t, 1 - levels), 115200, 8, 'Even', 2, idle_high=False)] == list(b"Hello, world!")
+
+    # A one-sample glitch on the idle line two bit times before a start bit does not hide the word
+    _, first = make_uart_trace(b"A", 1e6, 10e6)
+    _, second = make_uart_trace(b"B", 1e6, 10e6)
+    levels = np.concatenate([first, np.ones(40, dtype=np.int64), second])
+    levels[len(first) + 40] = 0
+    t = np.arange(len(levels)) / 10e6
+    assert [chr(a.value) for a in decode_uart(EdgeIndex.from_samples(t, levels), 1e6)] == ['A', 'B']
+
+    # Multi-megasample capture
+    data = np.random.default_rng(0).integers(0, 256, 20000).tolist()
+    t, levels = make_uart_trace(data, 1e6, 20e6)
+    start = time.perf_counter()
+    annotations = decode_uart(EdgeIndex.from_samples(t, levels), 1e6)
+    elapsed = time.perf_counter() - start
+    assert [a.value for a in annotations] == data
+
+    fig, ax, ax_digital = create_waveform_figure()
+    artists = draw_annotations(ax_digital, annotations, (t[0], t[len(t) // 100]), max_count=50)
+    assert 0 < len(artists) <= 50
+
+    print(f"✓ UART decoder tests passed ({len(levels)} samples in {elapsed * 1e3:.0f} ms)")
+
+def make_spi_trace(mosi_words, miso_words, cpol=0, cpha=0, word_bits=8, samples_per_bit=10):
+    """Synthesize MSB-first SPI CLK/MOSI/MISO/CS (active low) traces (test helper)"""
+    import numpy as np
+    half = samples_per_bit // 2
+    gap = 3 * samples_per_bit
+    clk, mosi, miso, cs = [cpol] * gap, [0] * gap, [0] * gap, [1] * gap
+    for out_word, in_word in zip(mosi_words, miso_words):
+        for k in range(word_bits - 1, -1, -1):
+            # CPHA 0: data set up half a bit before the leading edge
+            clk += [cpol] * half + [1 - cpol] * half if cpha == 0 else [1 - cpol] * half + [cpol] * half
+            mosi += [(out_word >> k) & 1] * samples_per_bit
+            miso += [(in_word >> k) & 1] * samples_per_bit
+            cs += [0] * samples_per_bit
+        clk, mosi, miso, cs = clk + [cpol] * gap, mosi + [0] * gap, miso + [0] * gap, cs + [1] * gap
+    return (np.arange(len(clk)) * 1e-8,) + tuple(np.array(x, dtype=np.int64) for x in (clk, mosi, miso, cs))
+
+def test_spi_decoder():
+    """Test SPI decoding in all four modes, with and without chip select, and CSV export"""
+    print("Testing SPI decoder...")
+    import csv
+    import tempfile
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from decoders import DECODERS, export_annotations_csv
+
+    mosi_words, miso_words = [0xA5, 0x3C, 0xFF, 0x01], [0x11, 0x22, 0x33, 0x44]
+    for cpol in (0, 1):
+        for cpha in (0, 1):
+            t, clk, mosi, miso, cs = make_spi_trace(mosi_words, miso_words, cpol, cpha)
+            frame = WaveformFrame(timestamp=0.0, digital={d: EdgeIndex.from_samples(t, x) for d, x in enumerate((clk, mosi, miso, cs))})
+            settings = {'clk': 'D0', 'mosi': 'D1', 'miso': 'D2', 'cs': 'D3', 'cpol': str(cpol), 'cpha': str(cpha),
+                        'word_bits': '8', 'bit_order': 'MSB first', 'cs_polarity': 'Low'}
+            annotations = DECODERS['SPI'].decode(frame, settings)
+            assert [a.value for a in annotations if a.lane == 'D1'] == mosi_words
+            assert [a.value for a in annotations if a.lane == 'D2'] == miso_words
+            # Without chip select, words are framed by clock pauses
+            settings.update(cs='None', miso='None')
+            assert [a.value for a in DECODERS['SPI'].decode(frame, settings)] == mosi_words
+
+    # 16-bit words read LSB first see the bits reversed
+    settings.update(word_bits='16', bit_order='LSB first', cs='D3')
+    t, clk, mosi, miso, cs = make_spi_trace([0x8003], [0], word_bits=16)
+    frame = WaveformFrame(timestamp=0.0, digital={d: EdgeIndex.from_samples(t, x) for d, x in [(0, clk), (1, mosi), (3, cs)]})
+    settings.update(cpol='0', cpha='0')
+    annotations = DECODERS['SPI'].decode(frame, settings)
+    assert annotations[0].value == 0xC001 and annotations[0].text == "0xC001"
+
+    with tempfile.TemporaryDirectory() as tmp:
+        export_annotations_csv(f"{tmp}/spi.csv", annotations)
+        with open(f"{tmp}/spi.csv") as f:
+            rows = list(csv.reader(f))
+        assert rows[0] == ['Start', 'End', 'Source', 'Type', 'Value', 'Text']
+        assert rows[1][2:] == ['D1', 'data', str(0xC001), '0xC001']
+        export_annotations_csv(f"{tmp}/spi_frames.csv", annotations, [7] * len(annotations))
+        with open(f"{tmp}/spi_frames.csv") as f:
+            rows = list(csv.reader(f))
+        assert rows[0][0] == 'Frame' and rows[1][0] == '7' and rows[1][3:] == ['D1', 'data', str(0xC001), '0xC001']
+
+    print("✓ SPI decoder tests passed")
+
+def make_i2c_trace(transfers, samples_per_bit=8):
+    """
+    Synthesize I2C SCL/SDA traces (test helper)
+
+    transfers: (address, read, data bytes, ACK levels or None for all ACK, 'P' or 'Sr')
+    """
+    import numpy as np
+    half = samples_per_bit // 2
+    scl, sda = [1] * samples_per_bit, [1] * samples_per_bit
+
+    def phase(clock, data):
+        scl.extend([clock] * half)
+        sda.extend([data] * half)
+
+    def send_bit(level):
+        phase(0, level)
+        phase(1, level)
+
+    previous = 'P'
+    for address, read, data, acks, end in transfers:
+        if previous == 'Sr':
+            phase(0, 1)
+            phase(1, 1)
+        phase(1, 0)  # SDA falls while SCL is high
+        phase(0, 0)
+        for value, ack in [((address << 1) | read, 0)] + list(zip(data, acks or [0] * len(data))):
+            for k in range(7, -1, -1):
+                send_bit((value >> k) & 1)
+            send_bit(ack)
+        if end == 'P':
+            phase(0, 0)
+            phase(1, 0)
+            phase(1, 1)  # SDA rises while SCL is high
+        previous = end
+    phase(1, 1)
+    return np.arange(len(scl)) * 1e-7, np.array(scl, dtype=np.int64), np.array(sda, dtype=np.int64)
+
+def test_i2c_decoder():
+    """Test I2C conditions, address/data/ACK decoding, error flags and the table search"""
+    print("Testing I2C decoder...")
+    import time
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from decoders import DECODERS, decode_i2c
+    from decoder_view import filter_annotations
+
+    # Register write pointer, repeated START, two-byte read ending in NACK
+    t, scl, sda = make_i2c_trace([(0x50, 0, [0x00, 0x10], None, 'Sr'), (0x50, 1, [0xAB, 0xCD], [0, 1], 'P')])
+    frame = WaveformFrame(timestamp=0.0, digital={0: EdgeIndex.from_samples(t, scl), 1: EdgeIndex.from_samples(t, sda)})
+    annotations = DECODERS['I2C'].decode(frame, {'scl': 'D0', 'sda': 'D1'})
+    assert [a.text for a in annotations] == ['S', 'Addr 0x50 W', 'ACK', '0x00', 'ACK', '0x10', 'ACK',
+                                             'Sr', 'Addr 0x50 R', 'ACK', '0xAB', 'ACK', '0xCD', 'NACK', 'P']
+    assert annotations[1].kind == 'address' and annotations[1].value == 0xA0
+    assert annotations[13].kind == 'nack' and all(a.lane == 'D1' for a in annotations)
+
+    # Same bus on analog channels
+    frame = WaveformFrame(timestamp=0.0, analog={1: (t, scl * 3.3), 2: (t, sda * 3.3)})
+    assert [a.text for a in DECODERS['I2C'].decode(frame, {'scl': 'CH1', 'sda': 'CH2'}, 1.65)] == \
+        [a.text for a in annotations]
+
+    # Capture starting mid-byte and ending mid-byte
+    cut = decode_i2c(EdgeIndex.from_samples(t[100:300], scl[100:300]), EdgeIndex.from_samples(t[100:300], sda[100:300]))
+    errors = [a.text for a in cut if a.kind == 'error']
+    assert errors[0].endswith("bits without START") and errors[-1].startswith("Incomplete byte")
+    assert 'Addr 0x50 R' not in [a.text for a in cut]
+
+    # Search over text, source and type
+    assert len(filter_annotations(annotations, 'nack')) == 1
+    assert len(filter_annotations(annotations, 'addr')) == 2
+    assert len(filter_annotations(annotations, '')) == len(annotations)
+
+    # Long capture
+    t, scl, sda = make_i2c_trace([(0x20 + i % 8, 0, list(range(16)), None, 'P') for i in range(1000)])
+    start = time.perf_counter()
+    annotations = decode_i2c(EdgeIndex.from_samples(t, scl), EdgeIndex.from_samples(t, sda))
+    elapsed = time.perf_counter() - start
+    assert sum(a.kind == 'data' for a in annotations) == 16000
+    assert not any(a.kind in ('error', 'nack') for a in annotations)
+
+    print(f"✓ I2C decoder tests passed ({len(scl)} samples in {elapsed * 1e3:.0f} ms)")
+
+def make_can_trace(frames, bit_samples=20, data_samples=None, sample_point=0.75):
+    """
+    Synthesize a CAN RX trace, recessive high (test helper)
+
+    frames: (identifier, payload, extended, fd, brs, acked, crc_xor); crc_xor
+    corrupts the transmitted CRC. The CRC uses a plain shift register, so it
+    cross-checks the decoder's table-based CRC.
+    """
+    import numpy as np
+    from decoders import CAN_CRC15, CAN_CRC17, CAN_CRC21, CAN_FD_LENGTHS
+
+    def bits_of(value, count):
+        return [(value >> k) & 1 for k in range(count - 1, -1, -1)]
+
+    def shift_crc(bits, crc):
+        width, poly, register = crc
+        for bit in bits:
+            feedback = (register >> (width - 1)) ^ bit
+            register = (register << 1) & ((1 << width) - 1)
+            if feedback & 1:
+                register ^= poly
+        return register
+
+    def stuff(bits, after_last=True):
+        out, run = [], 0
+        for i, bit in enumerate(bits):
+            run = run + 1 if out and out[-1] == bit else 1
+            out.append(bit)
+            if run == 5 and (after_last or i < len(bits) - 1):
+                out.append(1 - bit)
+                run = 1
+        return out
+
+    data_samples = data_samples or bit_samples
+    levels, widths = [1] * 12, [bit_samples] * 12
+    for identifier, payload, extended, fd, brs, acked, crc_xor in frames:
+        if extended:
+            head = [0] + bits_of(identifier >> 18, 11) + [1, 1] + bits_of(identifier & 0x3FFFF, 18) + [0]
+            head += [1, 0, brs, 0] if fd else [0, 0]
+        else:
+            head = [0] + bits_of(identifier, 11) + [0, 0] + ([1, 0, brs, 0] if fd else [0])
+        dlc = CAN_FD_LENGTHS.index(len(payload)) if fd else len(payload)
+        body = head + bits_of(dlc, 4) + sum((bits_of(b, 8) for b in payload), [])
+        if fd:
+            raw = stuff(body, after_last=False)
+            count = (len(raw) - len(body)) % 8
+            stuff_count = bits_of(count ^ (count >> 1), 3)
+            stuff_count.append(sum(stuff_count) % 2)
+            crc = CAN_CRC17 if len(payload) <= 16 else CAN_CRC21
+            crc_field = stuff_count + bits_of(shift_crc(raw + stuff_count, crc) ^ crc_xor, crc[0])
+            for k, bit in enumerate(crc_field):
+                if k % 4 == 0:
+                    raw.append(1 - raw[-1])  # Fixed stuff bit
+                raw.append(bit)
+        else:
+            raw = stuff(body + bits_of(shift_crc(body, CAN_CRC15) ^ crc_xor, 15))
+        raw_widths = [bit_samples] * len(raw)
+        tail = [1, 0 if acked else 1, 1] + [1] * 10
+        tail_widths = [bit_samples] * len(tail)
+        if brs:
+            # Data bit time from the BRS sample point to the CRC delimiter sample point
+            brs_bit = len(stuff(head[:-1], after_last=False)) - 1
+            raw_widths[brs_bit] = sample_point * bit_samples + (1 - sample_point) * data_samples
+            raw_widths[brs_bit + 1:] = [data_samples] * (len(raw) - brs_bit - 1)
+            tail_widths[0] = sample_point * data_samples + (1 - sample_point) * bit_samples
+        levels += raw + tail
+        widths += raw_widths + tail_widths
+    edges = np.cumsum(widths)
+    n = int(edges[-1])
+    rx = np.array(levels, dtype=np.uint8)[np.searchsorted(edges, np.arange(n) + 0.5, side='right')]
+    return np.arange(n) * 1e-8, rx
+
+def test_can_decoder():
+    """Test CAN and CAN FD decoding, CRC/ACK checks, bit-rate recovery and bus statistics"""
+    print("Testing CAN decoder...")
+    import time
+    import numpy as np
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from decoders import DECODERS, decode_can, frame_duration
+
+    frames = [(0x123, [1, 2, 3], False, False, 0, True, 0),
+              (0x1ABCDE01, [0xFF] * 8, True, False, 0, True, 0),
+              (0x7FF, [], False, False, 0, False, 0),
+              (0x055, [0] * 8, False, False, 0, True, 1)]
+    t, rx = make_can_trace(frames)
+    # CAN_H on an analog channel: 3.5 V dominant, 2.5 V recessive, with noise
+    can_h = np.where(rx == 0, 3.5, 2.5) + np.random.default_rng(0).normal(0, 0.03, len(rx))
+    frame = WaveformFrame(timestamp=0.0, analog={1: (t, can_h)})
+    settings = {'can': 'CH1', 'signal': 'CAN_H', 'bitrate': '5000000', 'data_bitrate': '2000000',
+                'sample_point': '75'}
+    annotations = DECODERS['CAN'].decode(frame, settings, threshold=3.0)
+    texts = [a.text for a in annotations if a.kind != 'data']
+    assert texts[:12] == ['SOF', 'ID 0x123', 'DLC 3', 'CRC 0x1CB9', 'ACK', 'EOF',
+                          'SOF', 'ID 0x1ABCDE01', 'DLC 8', 'CRC 0x6EDC', 'ACK', 'EOF']
+    assert texts[12:17] == ['SOF', 'ID 0x7FF', 'DLC 0', 'CRC 0x272F', 'No ACK']
+    assert texts[-1].startswith('CRC error')
+    assert [a.value for a in annotations if a.kind == 'data'][:11] == [1, 2, 3] + [0xFF] * 8
+
+    # Bit rate recovered from the edges gives the same result
+    settings['bitrate'] = 'Auto'
+    assert [a.text for a in DECODERS['CAN'].decode(frame, settings, threshold=3.0)] == [a.text for a in annotations]
+
+    statistics = DECODERS['CAN'].statistics(annotations, frame_duration(frame))
+    assert statistics['Error frames'] == 1
+    assert abs(statistics['Frames/s'] - 4 / frame_duration(frame)) < 1e-6
+    assert 0 < statistics['Bus load %'] < 100
+
+    # CAN FD with and without bit-rate switch, up to 64 data bytes, on an RX pin
+    frames = [(0x321, list(range(12)), False, True, 0, True, 0),
+              (0x100, list(range(64)), True, True, 1, True, 0),
+              (0x101, [0xAA] * 16, False, True, 1, True, 0)]
+    t, rx = make_can_trace(frames, bit_samples=20, data_samples=5)
+    annotations = decode_can(EdgeIndex.from_samples(t, rx), 5e6, 20e6, dominant_high=False, lane='D0')
+    assert [a.text for a in annotations if a.kind == 'control'] == \
+        ['DLC 9 (12 bytes) FD', 'DLC 15 (64 bytes) FD BRS', 'DLC 10 (16 bytes) FD BRS']
+    assert [a.value for a in annotations if a.kind == 'data'] == list(range(12)) + list(range(64)) + [0xAA] * 16
+    assert sum(a.kind == 'crc' for a in annotations) == 3 and not any(a.kind == 'error' for a in annotations)
+
+    # Long capture
+    rng = np.random.default_rng(1)
+    frames = [(int(rng.integers(0, 0x800)), rng.integers(0, 256, int(rng.integers(0, 9))).tolist(),
+               False, False, 0, True, 0) for _ in range(2000)]
+    t, rx = make_can_trace(frames, bit_samples=10)
+    start = time.perf_counter()
+    annotations = decode_can(EdgeIndex.from_samples(t, rx), 10e6, dominant_high=False)
+    elapsed = time.perf_counter() - start
+    assert sum(a.kind == 'address' for a in annotations) == 2000
+    assert not any(a.kind == 'error' for a in annotations)
+
+    print(f"✓ CAN decoder tests passed ({len(rx)} samples in {elapsed * 1e3:.0f} ms)")
+
+def test_parallel_decoder():
+    """Test parallel bus packing, hex/decimal labels and clocked sampling"""
+    print("Testing parallel bus decoder...")
+    import time
+    import numpy as np
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from decoders import DECODERS, decode_parallel, pack_bus, parse_sources
+
+    # Bus steps through 0x00, 0xA5, 0x3C, 0xFF every 100 samples; D8 clocks at the middle of each step
+    t = np.arange(400) * 1e-6
+    words = np.repeat([0x00, 0xA5, 0x3C, 0xFF], 100)
+    digital = {d: EdgeIndex.from_samples(t, (words >> d) & 1) for d in range(8)}
+    digital[8] = EdgeIndex.from_samples(t, (np.arange(400) % 100) >= 50)
+    frame = WaveformFrame(0.0, digital=digital)
+
+    points, values = pack_bus([digital[d] for d in range(8)])
+    assert points.tolist() == [0, 100, 200, 300] and values.tolist() == [0x00, 0xA5, 0x3C, 0xFF]
+
+    settings = {'bus': 'DATA', 'bits': 'D0-D7', 'clock': 'None', 'edge': 'Rising', 'radix': 'Hex'}
+    annotations = DECODERS['Parallel'].decode(frame, settings)
+    assert [a.text for a in annotations] == ['0x00', '0xA5', '0x3C', '0xFF']
+    assert annotations[1].lane == 'DATA[7:0]' and annotations[1].start == t[100] and annotations[1].end == t[200]
+    assert annotations[-1].end == t[-1]
+
+    settings.update(bits='D0-D3', radix='Dec')
+    assert [a.text for a in DECODERS['Parallel'].decode(frame, settings)] == ['0', '5', '12', '15']
+
+    settings.update(bits='D0-D7', clock='D8', radix='Hex')
+    annotations = DECODERS['Parallel'].decode(frame, settings)
+    assert [(a.value, a.start) for a in annotations] == [(v, t[50 + 100 * i]) for i, v in
+                                                         enumerate([0x00, 0xA5, 0x3C, 0xFF])]
+    settings.update(edge='Falling')
+    assert [a.value for a in DECODERS['Parallel'].decode(frame, settings)] == [0xA5, 0x3C, 0xFF]
+
+    # Bits listed MSB first reverse the bus; 16 bits get four hex digits
+    assert parse_sources('D7-D0')[0] == 'D7'
+    assert decode_parallel([digital[d] for d in range(8)] * 2)[1].text == '0xA5A5'
+
+    # Frame-rate cost on a deep record with 100k bus changes
+    rng = np.random.default_rng(3)
+    words = np.repeat(rng.integers(0, 256, 100_000), 100)
+    t = np.arange(len(words)) * 1e-9
+    bits = [EdgeIndex.from_samples(t, (words >> d) & 1) for d in range(8)]
+    start = time.perf_counter()
+    annotations = decode_parallel(bits)
+    elapsed = time.perf_counter() - start
+    assert len(annotations) == 1 + np.count_nonzero(np.diff(words))
+
+    print(f"✓ Parallel bus decoder tests passed ({len(words)} samples in {elapsed * 1e3:.0f} ms)")
+
+
+def test_analog_to_logic():
+    """Test the hysteresis comparator, threshold families and sub-sample crossing times"""
+    print("Testing analog-to-logic conversion...")
+    import time
+    import numpy as np
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from decoders import decode_uart, get_logic_trace
+    from logic_measurements import measure_logic
+    from utils import parse_logic_threshold
+
+    assert parse_logic_threshold('TTL') == (1.4, 1.4)
+    assert np.allclose(parse_logic_threshold('lvcmos2', 0.2), (1.15, 1.35))
+    assert np.allclose(parse_logic_threshold('0.9', 0.1), (0.85, 0.95))
+
+    # Noisy 1 kHz sine: hysteresis removes the chatter around the crossings
+    t = np.arange(20000) * 1e-7
+    clean = 1.65 + 1.65 * np.cos(2 * np.pi * 1e3 * t)
+    noisy = clean + np.random.default_rng(0).normal(0, 0.05, len(t))
+    assert len(EdgeIndex.from_analog(t, noisy, 1.65, 1.65).edges) > 10
+    trace = EdgeIndex.from_analog(t, noisy, 1.45, 1.85)
+    assert len(trace.edges) == 4 and trace.initial == 1
+    assert trace.state_at_index(trace.rising()[0]) == 1 and trace.state_at_index(trace.falling()[0]) == 0
+
+    # Crossing times are interpolated between samples
+    trace = EdgeIndex.from_analog(t, clean, 1.65, 1.65)
+    expected = np.array([0.25e-3, 0.75e-3, 1.25e-3])
+    assert np.abs(trace.edge_times()[:3] - expected).max() < 1e-9, trace.edge_times()[:3]
+    assert np.abs(trace.times(trace.edges[:3]) - expected).max() > 1e-9
+    assert trace.inverted().edge_times()[0] == trace.edge_times()[0]
+
+    # Sub-sample accuracy of the period of a coarsely sampled 3 MHz clock
+    t = np.arange(10000) * 1e-8
+    wave = np.sin(2 * np.pi * 3e6 * t)
+    period = measure_logic(EdgeIndex.from_analog(t, wave, -0.1, 0.1))[1]
+    assert abs(period - 1 / 3e6) < 1e-12, period
+
+    # Decoders take (falling, rising) thresholds for analog sources
+    t, bits = make_uart_trace(b"OK", 115200, 2e6)
+    analog = 3.3 * bits + np.random.default_rng(1).normal(0, 0.3, len(bits))
+    frame = WaveformFrame(0.0, analog={2: (t, analog)})
+    annotations = decode_uart(get_logic_trace(frame, 'CH2', parse_logic_threshold('LVCMOS3', 0.8)), 115200)
+    assert [a.value for a in annotations if a.kind == 'data'] == list(b"OK")
+
+    # 10M-point record
+    n = 10_000_000
+    t = np.arange(n) * 1e-9
+    wave = np.sin(2 * np.pi * 1e5 * t)
+    start = time.perf_counter()
+    trace = EdgeIndex.from_analog(t, wave, -0.1, 0.1)
+    elapsed = time.perf_counter() - start
+    assert len(trace.edges) == 2000
+
+    print(f"✓ Analog-to-logic tests passed ({n} points in {elapsed * 1e3:.0f} ms)")
+
+
+def test_logic_measurements():
+    """Test digital timing measurements and their running statistics"""
+    print("Testing logic measurements...")
+    import time
+    import numpy as np
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from logic_measurements import LOGIC_MEASUREMENTS, LogicMeasurements, RunningStatistics, measure_logic
+    from utils import format_measurement_value
+
+    names = [name for name, _ in LOGIC_MEASUREMENTS]
+    t = np.arange(1000) * 1e-6
+    clock = ((np.arange(1000) + 30) % 100) < 25  # 10 kHz, 25 % duty, starts mid-cycle
+    values = dict(zip(names, measure_logic(EdgeIndex.from_samples(t, clock))))
+    assert abs(values['Freq'] - 1e4) < 1e-6 and abs(values['Period'] - 1e-4) < 1e-12
+    assert abs(values['Duty'] - 25.0) < 1e-9 and values['Edges'] == 20
+    assert abs(values['+Wid min'] - 25e-6) < 1e-12 and abs(values['-Wid max'] - 75e-6) < 1e-12
+    values = dict(zip(names, measure_logic(EdgeIndex.from_samples(t, ~clock))))
+    assert abs(values['Duty'] - 75.0) < 1e-9
+
+    # Pulse widths without a full cycle; a flat line only has an edge count
+    pulse = np.zeros(1000, dtype=bool)
+    pulse[100:130] = True
+    values = dict(zip(names, measure_logic(EdgeIndex.from_samples(t, pulse))))
+    assert abs(values['+Wid max'] - 30e-6) < 1e-12 and np.isnan(values['Freq']) and np.isnan(values['-Wid min'])
+    values = measure_logic(EdgeIndex.from_samples(t, np.zeros(1000)))
+    assert values[-1] == 0 and np.isnan(values[:-1]).all()
+
+    assert format_measurement_value(25.0, 'DUTY') == "25.00 %"
+    assert format_measurement_value(20.0, 'EDGES') == "20"
+
+    # Running statistics match numpy over frames; NaN entries are skipped
+    rng = np.random.default_rng(5)
+    data = rng.normal(size=(50, 3, 4))
+    data[::7, 0, 1] = np.nan
+    statistics = RunningStatistics((3, 4))
+    for table in data:
+        statistics.update(table)
+    assert np.allclose(statistics.mean, np.nanmean(data, axis=0))
+    assert np.allclose(statistics.std, np.nanstd(data, axis=0, ddof=1))
+    assert np.allclose(statistics.minimum, np.nanmin(data, axis=0))
+    assert statistics.count[0, 1] == 50 - len(data[::7])
+
+    # Frames: only channels in the frame are measured and listed
+    measurements = LogicMeasurements()
+    for period in (100, 50):
+        square = ((np.arange(1000) % period) < period // 2)
+        frame = WaveformFrame(0.0, analog={1: (t, 3.3 * square)},
+                              digital={3: EdgeIndex.from_samples(t, square), 9: EdgeIndex.from_samples(t, pulse)})
+        measurements.process(frame)
+    assert sorted(measurements.view('Current')) == ['D3', 'D9'] and measurements.frames == 2
+    assert abs(measurements.view('Mean')['D3'][0] - 15e3) < 1e-6
+    assert abs(measurements.view('Max')['D3'][0] - 20e3) < 1e-6
+    assert measurements.view('Count')['D9'][0] == 0 and np.isnan(measurements.view('Mean')['D9'][0])
+    measurements.process(frame, (1.2, 1.6))
+    assert list(measurements.view('Current')) == ['D3', 'D9', 'CH1']
+    assert abs(measurements.view('Current')['CH1'][0] - 20e3) < 1e-6
+    measurements.reset()
+    assert measurements.frames == 0 and measurements.view('Current') == {}
+
+    # 16 channels of a 10M-point record with 100k edges each
+    n = 10_000_000
+    t = np.arange(n) * 1e-9
+    frame = WaveformFrame(0.0, digital={d: EdgeIndex.from_samples(t, (np.arange(n) // (100 + d)) % 2)
+                                        for d in range(16)})
+    start = time.perf_counter()
+    LogicMeasurements().process(frame)
+    elapsed = time.perf_counter() - start
+
+    print(f"✓ Logic measurement tests passed (16 channels in {elapsed * 1e3:.0f} ms)")
+
+
+def test_search():
+    """Test glitch, pulse-width, runt, setup/hold and pattern searches"""
+    print("Testing search...")
+    import itertools
+    import os
+    import tempfile
+    import time
+    import numpy as np
+    from acquisition import WaveformFrame
+    from edge_index import EdgeIndex
+    from decoders import parse_sources
+    from search import SEARCHES, parse_pattern, search_frames
+    from capture import CaptureFile, read_records
+    from recorder import CaptureRecorder
+
+    assert parse_sources('D0-D2, d7,CH1') == ['D0', 'D1', 'D2', 'D7', 'CH1']
+    assert parse_pattern('XXXX XXXX XXXX 1X0') == (0b101, 0b100)
+
+    # 10M points at 1 GSa/s: 10 MHz clock on D0 (rising at 50 + 100k ns), data on D1, glitches on D2
+    n = 10_000_000
+    t = np.arange(n) * 1e-9
+    index = np.arange(n)
+    clock = ((index // 50) % 2).astype(np.uint8)
+    data = np.zeros(n, dtype=np.uint8)
+    data[1000:2048] = 1         # rises 50 ns before its clock edge, falls 2 ns before one (setup)
+    data[4151:6000] = 1         # rises 1 ns after a clock edge (hold)
+    glitch = np.zeros(n, dtype=np.uint8)
+    glitch[5_000_000:5_000_005] = 1
+    glitch[7_000_000:7_000_300] = 1
+    glitch[8_000_000:8_000_003] = 0
+    glitch[9_000_000:9_000_002] = 1
+    voltage = np.zeros(n)
+    voltage[3_000_000:3_000_100] = 1.5  # runt
+    voltage[6_000_000:6_000_100] = 3.0  # full pulse
+    voltage[6_500_000:6_500_400] = 3.0
+    voltage[6_500_100:6_500_200] = 1.5  # negative runt inside a full pulse
+    frame = WaveformFrame(0.0, analog={1: (t, voltage)},
+                          digital={0: EdgeIndex.from_samples(t, clock), 1: EdgeIndex.from_samples(t, data),
+                                   2: EdgeIndex.from_samples(t, glitch)})
+
+    timings = {}
+
+    def run(name, **settings):
+        start = time.perf_counter()
+        events = SEARCHES[name].find(frame, settings, 1.4)
+        timings[name] = time.perf_counter() - start
+        return events
+
+    events = run('Glitch', source='D2', width='20n')
+    assert [round(e.start * 1e9) for e in events] == [5_000_000, 9_000_000]
+    assert events[0].text == 'Glitch +5.000 ns' and events[0].kind == 'glitch'
+
+    events = run('Pulse width', source='D2', polarity='Positive', min_width='100n', max_width='1u')
+    assert [(round(e.start * 1e9), round(e.end * 1e9)) for e in events] == [(7_000_000, 7_000_300)]
+
+    events = run('Runt', source='CH1', low='0.8', high='2.0')
+    assert [(e.text, round(e.start * 1e9)) for e in events] == [('Runt +100.000 ns', 3_000_000),
+                                                                ('Runt -100.000 ns', 6_500_100)]
+
+    events = run('Setup/Hold', clock='D0', edge='Rising', data='D1', setup='5n', hold='2n')
+    assert [(e.kind, round(e.start * 1e9)) for e in events] == [('setup', 2048), ('hold', 4150)]
+
+    events = run('Pattern', pattern='X10')
+    assert [(round(e.start * 1e9), round(e.end * 1e9)) for e in events][:2] == [(1000, 1050), (1100, 1150)]
+    assert all(frame.digital[1].state_at(e.start) == 1 and frame.digital[0].state_at(e.start) == 0
+               for e in events)
+
+    # Recordings: events are tagged with the frame they came from
+    results = search_frames([frame, WaveformFrame(0.0, sequence=7, digital=frame.digital)],
+                            SEARCHES['Glitch'], {'source': 'D2', 'width': '20n'})
+    assert [sequence for sequence, _ in results] == [0, 0, 7, 7]
+
+    # Recordings are searched record by record straight from their capture files; two
+    # recordings both start at sequence 0, so events are tagged with their record instead
+    with tempfile.TemporaryDirectory() as directory:
+        files = []
+        for name, offset in (('first.rcap', 10), ('second.rcap', 50)):
+            recorder = CaptureRecorder(os.path.join(directory, name), max_bytes=1)
+            for sequence in range(2):
+                levels = np.zeros(1000, dtype=np.uint8)
+                levels[100 * sequence + offset:100 * sequence + offset + 3] = 1
+                recorder.submit(WaveformFrame(float(sequence), sequence=sequence,
+                                              digital={2: EdgeIndex.from_levels(levels, 0.0, 1e-9)}))
+            recorder.close()
+            files += recorder.files
+        assert len(files) == 4
+        settings = {'source': 'D2', 'width': '20n'}
+        results = search_frames((record.frame() for record in read_records(files)), SEARCHES['Glitch'], settings)
+        assert [(sequence, round(e.start * 1e9)) for sequence, e in results] == [(0, 10), (1, 110), (0, 50),
+                                                                                (1, 150)]
+        records, refs = itertools.tee(read_records(files))
+        results = search_frames((record.frame() for record in records), SEARCHES['Glitch'], settings,
+                                keys=(record.ref for record in refs))
+        assert len({ref for ref, _ in results}) == 4
+        for ref, event in results:
+            # Every event's record reloads the frame it was found in
+            frame = CaptureFile(ref.filename, ref.offset).frame()
+            assert frame.sequence == ref.sequence
+            assert frame.digital[2].state_at(event.start + 1e-9) == 1
+        assert str(results[2][0]) == '0 (second_0000.rcap)'
+
+    slowest = max(timings, key=timings.get)
+    print(f"✓ Search tests passed (slowest: {slowest} in {timings[slowest] * 1e3:.0f} ms over {n} points)")
+
+
+def test_csv_export():
+    """Test the vectorized, chunked CSV writer against the CSV frame loader"""
+    print("Testing CSV export...")
+    import os
+    import tempfile
+    import threading
+    import time
+    import numpy as np
+    from acquisition import WaveformFrame, load_csv_frame
+    from edge_index import EdgeIndex
+    from export import format_fixed, write_csv
+
+    cells = [bytes(row).decode().strip() for row in format_fixed(np.array([0, -0.5, 1.25, -12, 3.14159, -4e-5]), 4)]
+    assert cells == ['0', '-0.5', '1.25', '-12', '3.1416', '0']
+
+    n = 1_000_003
+    t = -1e-3 + np.arange(n) * 1e-9
+    voltage = np.round(3.3 * np.sin(np.arange(n) * 1e-3) / 0.0129) * 0.0129
+    levels = (np.arange(n) // 777) % 2
+    frame = WaveformFrame(0.0, analog={1: (t, voltage), 3: (t[::2], voltage[::2])},
+                          digital={0: EdgeIndex.from_samples(t, levels), 7: EdgeIndex.from_samples(t, 1 - levels)})
+
+    with tempfile.TemporaryDirectory() as directory:
+        filename = os.path.join(directory, 'frame.csv')
+        fractions = []
+        start = time.perf_counter()
+        rows = write_csv(filename, frame, {7: 'CLK'}, chunk_rows=100_000, progress=fractions.append)
+        elapsed = time.perf_counter() - start
+        size = os.path.getsize(filename)
+        assert rows == n and fractions[-1] == 1.0 and len(fractions) == 11
+
+        with open(filename) as f:
+            assert f.readline().strip() == 'Time,CH1,CH3,D0,CLK'
+        loaded = load_csv_frame(filename)
+        assert np.abs(loaded.analog[1][0] - t).max() < 1e-15
+        assert np.abs(loaded.analog[1][1] - voltage).max() < 1e-9
+        assert np.allclose(loaded.analog[3][1][::2], voltage[::2], atol=1e-5)  # interpolated onto CH1's grid
+        assert np.array_equal(loaded.digital[0].edges, frame.digital[0].edges)
+
+        # Cancelling leaves no file behind
+        cancel = threading.Event()
+        cancel.set()
+        cancelled = os.path.join(directory, 'cancelled.csv')
+        assert write_csv(cancelled, frame, cancel=cancel) == 0
+        assert os.listdir(directory) == ['frame.csv']
+
+        # Digital-only frames use the edge index time axis
+        only_digital = WaveformFrame(0.0, digital={2: EdgeIndex.from_samples(t[:10], levels[:10])})
+        write_csv(filename, only_digital)
+        loaded = load_csv_frame(filename)
+        assert np.array_equal(loaded.digital[2].to_levels(), levels[:10])
+
+    print(f"✓ CSV export tests passed ({size / elapsed / 1e6:.0f} MB/s)")
+
+
+def test_capture_file():
+    """Test capture file round trips, column alignment and truncation detection"""
+    print("Testing capture files...")
+    import os
+    import tempfile
+    import time
+    import numpy as np
+    from acquisition import RawChannel, WaveformFrame
+    from capture import ALIGNMENT, CaptureFile, read_capture, write_capture
+    from edge_index import EdgeIndex
+
+    n = 2_000_001
+    rng = np.random.default_rng(3)
+    raw = RawChannel(rng.integers(0, 4096, n).astype(np.uint16), -1e-3, 1e-9, 0.002, -100.0, 2048.0)
+    byte_raw = RawChannel(rng.integers(0, 256, n).astype(np.uint8), -1e-3, 1e-9, 0.04, 0.0, 128.0)
+    t = raw.times()
+    assert np.allclose(raw.voltages()[:3], (raw.codes[:3] - 1948.0) * 0.002)
+    levels = (np.arange(n) // 333) % 2
+    frame = WaveformFrame(12.5, sequence=4, raw={1: raw, 2: byte_raw},
+                          analog={1: (t, raw.voltages()), 2: (t, byte_raw.voltages()),
+                                  4: (t, np.sin(np.arange(n) * 1e-4))},
+                          digital={0: EdgeIndex.from_levels(levels, -1e-3, 1e-9),
+                                   9: EdgeIndex.from_levels(1 - levels, -1e-3, 1e-9)})
+    settings = {'timebase': {'scale': '1e-4'}, 'channels': {'CH1': {'probe': '10'}}}
+
+    with tempfile.TemporaryDirectory() as directory:
+        filename = os.path.join(directory, 'frame.rcap')
+        start = time.perf_counter()
+        size = write_capture(filename, frame, settings)
+        elapsed = time.perf_counter() - start
+        assert size == os.path.getsize(filename)
+        assert size < 2 * n * 2 + n + 2 * n / 8 + 8 * ALIGNMENT  # codes, not float64 text
+
+        capture = CaptureFile(filename)
+        assert capture.settings == settings and capture.timestamp == 12.5 and capture.sequence == 4
+        assert all(column['offset'] % ALIGNMENT == 0 for column in capture.columns.values())
+        codes = capture.data('CH1')
+        assert isinstance(codes, np.memmap) and codes.dtype == np.uint16
+        assert np.array_equal(codes, raw.codes)
+        assert capture.data('CH2').dtype == np.uint8
+
+        loaded = read_capture(filename)
+        assert np.array_equal(loaded.analog[1][1], raw.voltages())
+        assert np.array_equal(loaded.analog[2][1], byte_raw.voltages())
+        assert np.abs(loaded.analog[4][0] - t).max() < 1e-15
+        assert np.abs(loaded.analog[4][1] - frame.analog[4][1]).max() < 2.0 / 65535  # quantized to 16 bits
+        assert np.array_equal(loaded.digital[0].edges, frame.digital[0].edges)
+        assert loaded.digital[9].initial == 1 and len(loaded.digital[9]) == n
+
+        # A truncated file is refused
+        truncated = os.path.join(directory, 'truncated.rcap')
+        with open(filename, 'rb') as src, open(truncated, 'wb') as dst:
+            dst.write(src.read(size - ALIGNMENT))
+        try:
+            CaptureFile(truncated)
+            assert False, "Truncated capture was accepted"
+        except ValueError:
+            pass
+
+    print(f"✓ Capture file tests passed ({size / elapsed / 1e6:.0f} MB/s)")
+
+
+def test_capture_recorder():
+    """Test streaming frames to rotated capture files with an index and drop counting"""
+    print("Testing capture recorder...")
+    import os
+    import tempfile
+    import threading
+    import time
+    import numpy as np
+    import recorder as recorder_module
+    from acquisition import AcquisitionPipeline, RawChannel, WaveformFrame
+    from capture import read_capture, read_index, scan_records
+    from recorder import CaptureRecorder
+
+    n = 100_000
+    rng = np.random.default_rng(5)
+
+    def make_frame(sequence):
+        raw = RawChannel(rng.integers(0, 4096, n).astype(np.uint16), 0.0, 1e-8, 0.001, 0.0, 2048.0)
+        return WaveformFrame(100.0 + sequence, analog={1: (raw.times(), raw.voltages())},
+                             sequence=sequence, raw={1: raw})
+
+    frames = [make_frame(i) for i in range(10)]
+    with tempfile.TemporaryDirectory() as directory:
+        # Every frame through the pipeline lands on disk; files rotate at ~0.5 MB
+        recorder = CaptureRecorder(os.path.join(directory, 'soak.rcap'), max_bytes=500_000, queue_depth=32,
+                                   settings={'run': 'soak'})
+        pipeline = AcquisitionPipeline()
+        pipeline.add_stage(recorder.submit)
+        for frame in frames:
+            pipeline.submit(frame)
+        recorder.close()
+        assert recorder.frames_written == 10 and recorder.frames_dropped == 0
+        assert len(recorder.files) == 4  # three 200 kB frames per file
+        assert os.path.basename(recorder.files[1]) == 'soak_0001.rcap'
+
+        sequences = []
+        for filename in recorder.files:
+            index = read_index(filename)
+            assert np.array_equal(index, scan_records(filename))
+            for entry in index:
+                loaded = read_capture(filename, offset=int(entry['offset']))
+                assert loaded.sequence == entry['sequence'] and loaded.timestamp == entry['timestamp']
+                assert np.array_equal(loaded.raw[1].codes, frames[loaded.sequence].raw[1].codes)
+                sequences.append(loaded.sequence)
+        assert sequences == list(range(10))
+
+        # Time-based rotation
+        recorder = CaptureRecorder(os.path.join(directory, 'timed'), max_seconds=5.0)
+        for frame in frames:
+            recorder.submit(frame)
+        recorder.close()
+        assert [len(read_index(f)) for f in recorder.files] == [5, 5]
+
+        # A stalled disk drops frames instead of blocking the submitter
+        gate = threading.Event()
+        original = recorder_module.write_record
+
+        def stalled_write(*args):
+            gate.wait()
+            return original(*args)
+
+        recorder_module.write_record = stalled_write
+        try:
+            recorder = CaptureRecorder(os.path.join(directory, 'stalled.rcap'), queue_depth=3)
+            recorder.submit(frames[0])
+            while recorder.pending:
+                time.sleep(0.001)
+            start = time.perf_counter()
+            accepted = [recorder.submit(frame) for frame in frames[1:]]
+            assert time.perf_counter() - start < 5.0  # Loose: only catches submit() waiting on the writer
+            assert accepted == [True] * 3 + [False] * 6
+            assert recorder.status()['dropped'] == 6
+            gate.set()
+            recorder.close()
+        finally:
+            recorder_module.write_record = original
+        assert recorder.frames_written == 4
+        assert list(read_index(recorder.files[0])['sequence']) == [0, 1, 2, 3]
+
+        # An interrupted recording (truncated last record) still indexes its complete frames
+        filename = os.path.join(directory, 'soak_0000.rcap')
+        os.remove(filename + '.idx')
+        with open(filename, 'r+b') as f:
+            f.truncate(os.path.getsize(filename) - 100)
+        assert len(read_index(filename)) == 2
+
+    print("✓ Capture recorder tests passed")
+
+
+def test_hdf5_export():
+    """Test incremental HDF5 export of frames and capture recordings"""
+    print("Testing HDF5 export...")
+    import json
+    import os
+    import tempfile
+    import h5py
+    import numpy as np
+    from acquisition import RawChannel, WaveformFrame
+    from edge_index import EdgeIndex
+    from hdf5_export import convert_recording, write_hdf5
+    from recorder import CaptureRecorder
+
+    n = 100_003
+    rng = np.random.default_rng(9)
+
+    def make_frame(sequence):
+        raw = RawChannel(rng.integers(0, 4096, n).astype(np.uint16), -1e-4, 1e-9,
+                         0.001 * (1 + sequence), 0.0, 2048.0)
+        t = raw.times()
+        levels = (np.arange(n) // (50 + sequence)) % 2
+        return WaveformFrame(50.0 + sequence, sequence=sequence, raw={1: raw},
+                             analog={1: (t, raw.voltages()), 2: (t, np.cos(t * 1e5))},
+                             digital={3: EdgeIndex.from_levels(levels, -1e-4, 1e-9)})
+
+    frames = [make_frame(i) for i in range(4)]
+    with tempfile.TemporaryDirectory() as directory:
+        filename = os.path.join(directory, 'frames.h5')
+        assert write_hdf5(filename, iter(frames), settings={'probe': 10}) == 4
+        with h5py.File(filename, 'r') as f:
+            assert json.loads(f.attrs['settings']) == {'probe': 10}
+            assert list(f['sequence']) == [0, 1, 2, 3] and f['timestamp'][3] == 53.0
+            codes = f['CH1/codes']
+            assert codes.shape == (4, n) and codes.dtype == np.uint16 and codes.compression == 'gzip'
+            assert codes.chunks[0] == 1 and codes.maxshape == (None, n)
+            assert np.array_equal(codes[2], frames[2].raw[1].codes)
+            preamble = f['CH1/preamble'][2]
+            volts = (codes[2] - preamble['y_reference'] - preamble['y_origin']) * preamble['y_increment']
+            assert np.array_equal(volts, frames[2].analog[1][1])
+            assert f['CH1'].attrs['y_increment'] == 0.001
+            assert f['CH2/codes'].dtype == np.uint16  # quantized
+            digital = f['D3']
+            levels = np.unpackbits(digital[1], count=digital.attrs['length'])
+            assert np.array_equal(levels, frames[1].digital[3].to_levels())
+
+        # Frames with missing channels or another record length are skipped, not fatal
+        missing = WaveformFrame(60.0, sequence=9, raw={1: frames[1].raw[1]},
+                                digital={3: frames[1].digital[3]})
+        short = WaveformFrame(0.0, digital={3: EdgeIndex.from_levels([0, 1])})
+        skipped = os.path.join(directory, 'skipped.h5')
+        assert write_hdf5(skipped, [frames[0], missing, short, frames[2]]) == 2
+        with h5py.File(skipped, 'r') as f:
+            assert list(f['sequence']) == [0, 2]
+
+        # A failed export leaves the previous file and no partial file
+        def failing_frames():
+            yield frames[3]
+            raise IOError("transfer failed")
+
+        try:
+            write_hdf5(filename, failing_frames())
+            assert False, "Failure was swallowed"
+        except IOError:
+            pass
+        assert not os.path.exists(filename + '.part')
+        with h5py.File(filename, 'r') as f:
+            assert f['CH1/codes'].shape[0] == 4
+
+        # A rotated recording converts into one file
+        recorder = CaptureRecorder(os.path.join(directory, 'run.rcap'), max_bytes=400_000)
+        for frame in frames:
+            recorder.submit(frame)
+        recorder.close()
+        assert len(recorder.files) > 1
+        converted = os.path.join(directory, 'run.h5')
+        assert convert_recording(converted, recorder.files, 'none') == 4
+        with h5py.File(converted, 'r') as f:
+            assert list(f['sequence']) == [0, 1, 2, 3] and f['CH1/codes'].compression is None
+            assert np.array_equal(f['CH1/codes'][3], frames[3].raw[1].codes)
+
+    print("✓ HDF5 export tests passed")
+
+
+def test_raw_frames():
+    """Test frames that keep raw ADC codes and scale them to volts on demand"""
+    print("Testing raw-code frames...")
+    import numpy as np
+    from acquisition import RawChannel, WaveformFrame
+    from decoders import frame_duration, get_logic_trace
+    from edge_index import EdgeIndex
+    from raster_view import RasterCanvas
+
+    n = 1_000_000
+    codes = (2048 + 1500 * np.sin(np.arange(n) * 2e-4)).astype(np.uint16)
+    raw = RawChannel(codes, -5e-4, 1e-9, 0.002, -48.0, 2048.0)
+    frame = WaveformFrame(1.0, raw={1: raw})
+    t = -5e-4 + np.arange(n) * 1e-9
+    volts = (codes - 2000.0) * 0.002
+
+    # Looked up as (time, volts) like array channels, but nothing is kept
+    assert 1 in frame.analog and list(frame.analog) == [1] and len(frame.analog) == 1
+    time_data, voltage_data = frame.analog[1]
+    assert np.allclose(time_data, t, rtol=0, atol=1e-15) and np.array_equal(voltage_data, volts)
+    assert frame.nbytes == codes.nbytes
+    eager = WaveformFrame(1.0, analog={1: (t, volts)})
+    assert eager.nbytes / frame.nbytes == 8
+    assert np.isclose(frame_duration(frame), (n - 1) * 1e-9)
+
+    # Windows convert only the samples in range, float32 on request
+    window_t, window_v = frame.analog_window(1, (0.0, 1e-6), np.float32)
+    first = int(round((window_t[0] + 5e-4) / 1e-9))
+    assert window_v.dtype == np.float32 and 1001 < len(window_t) <= 1005
+    assert window_t[0] < 0.0 and window_t[-1] > 1e-6
+    assert np.allclose(window_v, volts[first:first + len(window_v)], atol=1e-5)
+    array_t, array_v = eager.analog_window(1, (0.0, 1e-6))
+    assert array_t[0] < 0.0 and array_t[-1] >= 1e-6 and len(array_t) < 1005
+    assert np.shares_memory(array_v, volts)
+
+    # The comparator runs on the codes with the thresholds converted to codes
+    coded = get_logic_trace(frame, 'CH1', (-0.5, 0.5))
+    reference = EdgeIndex.from_analog(t, volts, -0.5, 0.5)
+    assert np.array_equal(coded.edges, reference.edges) and coded.initial == reference.initial
+    assert np.allclose(coded.edge_times(), reference.edge_times(), rtol=0, atol=1e-13)
+
+    # Rasterizing the whole frame matches the array frame
+    canvas = RasterCanvas(200, 100)
+    image = canvas.render(frame, {1: (-4.0, 4.0)}).copy()
+    assert np.array_equal(image, canvas.render(eager, {1: (-4.0, 4.0)}))
+
+    # The spectrum and tone stages read float32 volts and the sample interval, no time array
+    from spectrum import SpectrumAnalyzer, ToneMonitor
+    samples, dt = frame.analog_samples(1, np.float32)
+    assert samples.dtype == np.float32 and dt == 1e-9
+    freqs, magnitude = SpectrumAnalyzer().process(frame)[1]
+    eager_freqs, eager_magnitude = SpectrumAnalyzer().process(eager)[1]
+    significant = eager_magnitude > -80.0  # float32 rounding only shows far below the signal
+    assert np.allclose(freqs, eager_freqs, rtol=1e-6) and significant.any()
+    assert np.allclose(magnitude[significant], eager_magnitude[significant], atol=1e-3)
+    tones = ToneMonitor([31830.99, 1e6])
+    assert np.allclose(tones.process(frame)[1], tones.process(eager)[1], rtol=1e-5)
+
+    # The matplotlib view converts the whole record when autoscaling, only the visible range when zoomed
+    from waveform_figure import create_trace_lines, create_waveform_figure, update_trace_lines
+    fig, ax, ax_digital = create_waveform_figure()
+    lines, digital_lines = create_trace_lines(ax, ax_digital)
+    update_trace_lines(frame, lines, digital_lines)
+    assert len(lines[1].get_xdata()) == n
+    ax.set_xlim(0.0, 1e-6)
+    update_trace_lines(frame, lines, digital_lines)
+    assert len(lines[1].get_xdata()) < 1010 and lines[1].get_ydata().dtype == np.float32
+
+    # Assigning arrays replaces the codes
+    frame.analog[1] = (t[:10], volts[:10])
+    assert 1 not in frame.raw and frame.raw_channel(1) is None and len(frame.analog[1][0]) == 10
+    del frame.analog[1]
+    assert not frame.analog
+
+    print("✓ Raw-code frame tests passed")
+
+
 def test_imports():
     """Test that all modules can be imported"""
     print("Testing imports...")
@@ -107,6 +1545,30 @@ def main():
         test_imports()
         test_config()
         test_utils()
+        test_persistence()
+        test_acquisition_pipeline()
+        test_headless_renderer()
+        test_raster_view()
+        test_spectrum()
+        test_spectrum_averaging()
+        test_spectrogram_buffer()
+        test_tone_monitor()
+        test_streaming_welch()
+        test_harmonic_analysis()
+        test_edge_index()
+        test_uart_decoder()
+        test_spi_decoder()
+        test_i2c_decoder()
+        test_can_decoder()
+        test_parallel_decoder()
+        test_analog_to_logic()
+        test_logic_measurements()
+        test_search()
+        test_csv_export()
+        test_capture_file()
+        test_capture_recorder()
+        test_hdf5_export()
+        test_raw_frames()
 
         print("\n✓ All tests passed! The RIGOL GUI components are working correctly.")
         return 0
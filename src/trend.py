@@ -0,0 +1,81 @@
+"""
+Measurement trend logging for the RIGOL DHO954 GUI
+Appends one timestamped CSV row of measurement values per frame
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+import logging
+import os
+import threading
+from datetime import datetime
+from typing import Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+
+class TrendLogger:
+    """
+    CSV logger whose columns are fixed by the first logged row of each file
+
+    A row with a column the current file does not have (e.g. a channel or
+    tone enabled while logging) starts a new file, <name>_1.csv, <name>_2.csv,
+    ..., so no values are dropped.
+    """
+
+    def __init__(self, filename: str):
+        """
+        Open a trend log
+
+        Args:
+            filename: CSV file to create (overwritten)
+        """
+        self.filename = filename
+        self.files = [filename]
+        self._file = open(filename, 'w')
+        self._columns: Optional[List[str]] = None
+        self._lock = threading.Lock()
+        self.rows = 0
+
+    def _next_file(self) -> None:
+        """Close the current file and continue in a new one with its own header"""
+        base, extension = os.path.splitext(self.filename)
+        filename = f"{base}_{len(self.files)}{extension}"
+        self._file.close()
+        self._file = open(filename, 'w')
+        self._columns = None
+        self.files.append(filename)
+
+    def log(self, timestamp: float, values: Dict[str, float]) -> None:
+        """
+        Append one row
+
+        Args:
+            timestamp: Acquisition time (seconds since the epoch)
+            values: Measurement values keyed by column name; missing values
+                are left empty, new columns start a new file
+        """
+        with self._lock:
+            if self._file is None:
+                return
+            if self._columns is not None and not set(values) <= set(self._columns):
+                added = sorted(set(values) - set(self._columns))
+                self._next_file()
+                logger.warning(f"Trend columns {', '.join(added)} added; continuing in {self.files[-1]}")
+            if self._columns is None:
+                self._columns = list(values)
+                self._file.write(','.join(['Timestamp'] + self._columns) + '\n')
+            cells = [datetime.fromtimestamp(timestamp).isoformat(timespec='milliseconds')]
+            for column in self._columns:
+                value = values.get(column)
+                cells.append('' if value is None else f"{value:.6g}")
+            self._file.write(','.join(cells) + '\n')
+            self.rows += 1
+
+    def close(self) -> None:
+        """Flush and close the log"""
+        with self._lock:
+            if self._file is not None:
+                self._file.close()
+                self._file = None
+                logger.info(f"Trend log {self.filename} closed after {self.rows} rows in {len(self.files)} files")
@@ -5,7 +5,7 @@ Author: Sandesh Ghimire <sandesh@soccentric.com>
 """
 
 import logging
-from typing import Optional
+from typing import Optional, Tuple
 
 
 def setup_logging(level: str = "INFO", log_file: Optional[str] = None) -> None:
@@ -57,6 +57,14 @@ def format_measurement_value(value: float, measurement_type: str) -> str:
             return f"{value*1e6:.3f} µs"
         else:
             return f"{value*1e9:.3f} ns"
+    elif measurement_type in ['THD', 'SINAD', 'SNR']:
+        return f"{value:.2f} dB"
+    elif measurement_type == 'ENOB':
+        return f"{value:.2f} bits"
+    elif measurement_type == 'DUTY':
+        return f"{value:.2f} %"
+    elif measurement_type == 'EDGES':
+        return f"{value:.0f}" if value == int(value) else f"{value:.2f}"
     else:  # Voltage measurements
         if abs(value) >= 1:
             return f"{value:.3f} V"
@@ -66,6 +74,49 @@ def format_measurement_value(value: float, measurement_type: str) -> str:
             return f"{value*1e6:.3f} µV"
 
 
+def format_time_value(value: float) -> str:
+    """
+    Format a (possibly negative) time with an appropriate unit
+
+    Args:
+        value: Time in seconds
+
+    Returns:
+        Formatted string with units
+    """
+    magnitude = abs(value)
+    if magnitude >= 1:
+        return f"{value:.6f} s"
+    elif magnitude >= 1e-3:
+        return f"{value*1e3:.6f} ms"
+    elif magnitude >= 1e-6:
+        return f"{value*1e6:.3f} µs"
+    else:
+        return f"{value*1e9:.3f} ns"
+
+
+SI_PREFIXES = {'p': 1e-12, 'n': 1e-9, 'u': 1e-6, 'µ': 1e-6, 'm': 1e-3, 'k': 1e3, 'M': 1e6, 'G': 1e9}
+
+
+def parse_si_value(text: str) -> float:
+    """
+    Parse a number with an optional SI prefix and unit, e.g. '10n', '2.5 us', '1e-6'
+
+    Args:
+        text: Value as typed by the user
+
+    Returns:
+        Value in base units
+
+    Raises:
+        ValueError: If the text is not a number
+    """
+    text = text.strip().rstrip('sVHz').strip()
+    if text and text[-1] in SI_PREFIXES:
+        return float(text[:-1]) * SI_PREFIXES[text[-1]]
+    return float(text)
+
+
 def validate_channel_number(channel: int) -> bool:
     """Validate channel number (1-4)"""
     return 1 <= channel <= 4
@@ -159,3 +210,24 @@ def get_threshold_voltage(threshold_type: str) -> float:
         'LVCMOS2': 1.25
     }
     return thresholds.get(threshold_type, 1.5)
+
+
+def parse_logic_threshold(text: str, hysteresis: float = 0.0) -> Tuple[float, float]:
+    """
+    Comparator thresholds for converting analog channels to logic
+
+    Args:
+        text: Threshold family (e.g. 'TTL', 'LVCMOS2') or a level in volts
+        hysteresis: Distance between the falling and rising thresholds in volts
+
+    Returns:
+        Tuple of (falling, rising) thresholds centred on the level
+    """
+    family = text.strip().upper()
+    if is_valid_threshold_type(family) and family != 'CUSTOM':
+        level = get_threshold_voltage(family)
+    else:
+        level = float(text)
+    if hysteresis < 0:
+        raise ValueError("Hysteresis must not be negative")
+    return level - hysteresis / 2, level + hysteresis / 2
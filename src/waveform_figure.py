@@ -0,0 +1,247 @@
+"""
+Waveform figure construction shared by the GUI and the headless renderer
+Builds the oscilloscope-styled matplotlib Figure without any Tk dependency
+
+Author: Sandesh Ghimire <sandesh@soccentric.com>
+"""
+
+from typing import Dict, Optional, Tuple
+
+import numpy as np
+from matplotlib.axes import Axes
+from matplotlib.figure import Figure
+from matplotlib.gridspec import GridSpec
+from matplotlib.image import AxesImage
+from matplotlib.lines import Line2D
+
+ANALOG_COLORS = ['#00ff00', '#ffff00', '#00ffff', '#ff00ff']
+DIGITAL_COLORS = ['#00ff00', '#ffff00', '#00ffff', '#ff00ff', '#ff8800', '#00ff88',
+                  '#8800ff', '#ff0088', '#88ff00', '#0088ff', '#ff8888', '#88ff88',
+                  '#8888ff', '#ffff88', '#ff88ff', '#88ffff']
+
+
+def style_axes(ax: Axes, ylabel: str, xlabel: str = 'Time') -> None:
+    """
+    Apply the dark oscilloscope theme to an axes
+
+    Args:
+        ax: Axes to style
+        ylabel: Y axis label
+        xlabel: X axis label
+    """
+    ax.set_facecolor('#001a00')
+    ax.grid(True, color='#003300', linestyle='-', linewidth=0.5)
+    ax.set_xlabel(xlabel, color='white', fontsize=9)
+    ax.set_ylabel(ylabel, color='white', fontsize=9)
+    ax.tick_params(colors='white', labelsize=8)
+    for spine in ('bottom', 'top', 'left', 'right'):
+        ax.spines[spine].set_color('white')
+
+
+def create_waveform_figure(figsize: Tuple[float, float] = (8, 6), dpi: int = 100) -> Tuple[Figure, Axes, Axes]:
+    """
+    Create the waveform figure with analog (top) and digital (bottom) subplots
+
+    Args:
+        figsize: Figure size in inches
+        dpi: Figure resolution
+
+    Returns:
+        Tuple of (figure, analog_axes, digital_axes)
+    """
+    fig = Figure(figsize=figsize, dpi=dpi, facecolor='black')
+
+    # Analog waveform subplot (top)
+    ax = fig.add_subplot(211)
+    style_axes(ax, 'Voltage (V)')
+
+    # Digital waveform subplot (bottom)
+    ax_digital = fig.add_subplot(212)
+    style_axes(ax_digital, 'Digital')
+    ax_digital.set_ylim(-1, 16)
+    ax_digital.set_yticks(range(16))
+    ax_digital.set_yticklabels([f'D{i}' for i in range(16)])
+
+    fig.tight_layout()
+    return fig, ax, ax_digital
+
+
+def create_spectrum_axes(fig: Figure) -> Axes:
+    """
+    Add the (initially hidden) spectrum subplot below the waveform subplots
+
+    Args:
+        fig: Figure created by create_waveform_figure
+
+    Returns:
+        Spectrum axes
+    """
+    ax_fft = fig.add_subplot(313)
+    style_axes(ax_fft, 'Magnitude (dBV)', xlabel='Frequency (Hz)')
+    ax_fft.set_ylim(-120, 20)
+    ax_fft.set_visible(False)
+    return ax_fft
+
+
+def create_waterfall_axes(fig: Figure, rows: int) -> Tuple[Axes, AxesImage]:
+    """
+    Add the (initially hidden) waterfall subplot and its image artist
+
+    Args:
+        fig: Figure created by create_waveform_figure
+        rows: Number of spectra shown (newest at the top)
+
+    Returns:
+        Tuple of (waterfall_axes, waterfall_image)
+    """
+    ax_waterfall = fig.add_subplot(313)
+    style_axes(ax_waterfall, 'Frames ago', xlabel='Frequency (Hz)')
+    ax_waterfall.grid(False)
+    image = ax_waterfall.imshow([[-120.0]], origin='lower', aspect='auto', interpolation='nearest',
+                                cmap='inferno', vmin=-120, vmax=20, extent=(0, 1, -rows, 0))
+    ax_waterfall.set_visible(False)
+    return ax_waterfall, image
+
+
+def set_spectrum_visible(fig: Figure, ax: Axes, ax_digital: Axes, ax_fft: Axes, visible: bool,
+                         ax_waterfall: Optional[Axes] = None, waterfall: bool = False) -> None:
+    """
+    Switch between the time-domain layout and the layouts with spectrum rows
+
+    Args:
+        fig: Waveform figure
+        ax: Analog axes
+        ax_digital: Digital axes
+        ax_fft: Spectrum axes
+        visible: Show the spectrum subplot
+        ax_waterfall: Waterfall axes, if the figure has one
+        waterfall: Also show the waterfall below the spectrum
+    """
+    waterfall = visible and waterfall and ax_waterfall is not None
+    grid = GridSpec(2 + visible + waterfall, 1, figure=fig)
+    ax.set_subplotspec(grid[0])
+    ax_digital.set_subplotspec(grid[1])
+    # Hidden axes also move to this grid: tight_layout refuses figures whose
+    # subplot specs come from grids with incompatible row counts
+    ax_fft.set_subplotspec(grid[2] if visible else grid[-1])
+    ax_fft.set_visible(visible)
+    ax_fft.set_in_layout(visible)
+    if ax_waterfall is not None:
+        ax_waterfall.set_subplotspec(grid[3] if waterfall else grid[-1])
+        ax_waterfall.set_visible(waterfall)
+        ax_waterfall.set_in_layout(waterfall)
+    fig.tight_layout()
+
+
+def create_spectrum_lines(ax_fft: Axes) -> Dict[int, Line2D]:
+    """
+    Create one spectrum line artist per analog channel
+
+    Args:
+        ax_fft: Spectrum axes
+
+    Returns:
+        Spectrum lines keyed by channel number
+    """
+    spectrum_lines = {}
+    for i in range(1, 5):
+        line, = ax_fft.plot([], [], color=ANALOG_COLORS[i-1], linewidth=1.0, label=f'CH{i}')
+        spectrum_lines[i] = line
+    return spectrum_lines
+
+
+def create_trace_lines(ax: Axes, ax_digital: Axes) -> Tuple[Dict[int, Line2D], Dict[int, Line2D]]:
+    """
+    Create one line artist per analog (CH1-CH4) and digital (D0-D15) channel
+
+    Args:
+        ax: Analog axes
+        ax_digital: Digital axes
+
+    Returns:
+        Tuple of (analog_lines, digital_lines) keyed by channel number
+    """
+    waveform_lines = {}
+    for i in range(1, 5):
+        line, = ax.plot([], [], color=ANALOG_COLORS[i-1], linewidth=1.5, label=f'CH{i}')
+        waveform_lines[i] = line
+
+    ax.legend(loc='upper right', facecolor='black', edgecolor='white',
+              labelcolor='white', fontsize=8)
+
+    digital_lines = {}
+    for i in range(16):
+        line, = ax_digital.plot([], [], color=DIGITAL_COLORS[i], linewidth=1.0,
+                                drawstyle='steps-post', label=f'D{i}')
+        digital_lines[i] = line
+
+    return waveform_lines, digital_lines
+
+
+def update_trace_lines(frame, waveform_lines: Dict[int, Line2D], digital_lines: Dict[int, Line2D]) -> None:
+    """
+    Load a frame's channel data into the trace line artists
+
+    Args:
+        frame: WaveformFrame to display
+        waveform_lines: Analog line artists keyed by channel number
+        digital_lines: Digital line artists keyed by channel number
+    """
+    for ch in frame.analog:
+        line = waveform_lines[ch]
+        # Autoscaled axes show the whole record; zoomed ones only convert what is visible
+        time_range = None if line.axes.get_autoscalex_on() else line.axes.get_xlim()
+        line.set_data(*frame.analog_window(ch, time_range, np.float32))
+
+    for d, edges in frame.digital.items():
+        # Only the corners of the step trace; offset each channel vertically
+        time_data, levels = edges.step_points()
+        digital_lines[d].set_data(time_data, levels * 0.8 + d)
+
+
+ANNOTATION_COLORS = {
+    'data': '#00ccff',
+    'address': '#ffcc00',
+    'start': '#00ff00',
+    'stop': '#ff8800',
+    'ack': '#00ff88',
+    'nack': '#ff4444',
+    'control': '#cc88ff',
+    'crc': '#aaaaaa',
+    'error': '#ff0000',
+}
+
+
+def annotation_lane_y(lane: str) -> float:
+    """Y position on the digital axes for annotations of a source lane"""
+    if lane.startswith('D') and lane[1:].isdigit():
+        return int(lane[1:]) + 0.4
+    return -0.6  # Analog sources: below D0
+
+
+def draw_annotations(ax_digital: Axes, annotations, time_range: Optional[Tuple[float, float]] = None,
+                     max_count: int = 300) -> list:
+    """
+    Overlay decoded protocol annotations on the digital subplot
+
+    Args:
+        ax_digital: Digital axes
+        annotations: decoders.Annotation objects in time order
+        time_range: Only annotations overlapping (start, end) are drawn
+        max_count: Upper bound on the number of text artists created
+
+    Returns:
+        Created artists (remove them before drawing a new set)
+    """
+    artists = []
+    for annotation in annotations:
+        if time_range is not None and (annotation.end < time_range[0] or annotation.start > time_range[1]):
+            continue
+        if len(artists) >= max_count:
+            break
+        color = ANNOTATION_COLORS.get(annotation.kind, 'white')
+        artists.append(ax_digital.text((annotation.start + annotation.end) / 2, annotation_lane_y(annotation.lane),
+                                       annotation.text, color='black', fontsize=7, ha='center', va='center',
+                                       clip_on=True, bbox={'boxstyle': 'round,pad=0.15', 'facecolor': color,
+                                                           'edgecolor': 'none', 'alpha': 0.85}))
+    return artists